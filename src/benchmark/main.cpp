@@ -0,0 +1,124 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/* Compares a full table scan of a database through the plain VFS with the same scan
+ * of its compressed copy through CompressedVfs.
+ *
+ * Usage: sqlite4esl-benchmark [rows] [directory]
+ */
+
+#include <sqlite4esl/database/CompressedVfs.h>
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void createDatabase(const std::string& file, long rows) {
+	std::remove(file.c_str());
+
+	sqlite3* connectionHandle = nullptr;
+	sqlite3_open(file.c_str(), &connectionHandle);
+	std::unique_ptr<sqlite3, int(*)(sqlite3*)> connectionHandlePtr(connectionHandle, sqlite3_close_v2);
+
+	std::string sql = "CREATE TABLE t(x INTEGER, t TEXT);"
+			"WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<" + std::to_string(rows) + ") "
+			"INSERT INTO t SELECT i, 'customer-' || (i%1000) || '-status-active-region-europe' FROM c;";
+	char* errorMessage = nullptr;
+	if(sqlite3_exec(connectionHandle, sql.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+		std::string message = errorMessage ? errorMessage : "unknown error";
+		sqlite3_free(errorMessage);
+		throw std::runtime_error("Cannot create \"" + file + "\": " + message);
+	}
+}
+
+void scan(const std::string& label, const std::string& file, bool compression) {
+	std::vector<std::pair<std::string, std::string>> settings {
+		{"URI", "file:" + file},
+		{"readOnly", "true"},
+		{"ioStatistics", "true"}
+	};
+	if(compression) {
+		settings.emplace_back("compression", "true");
+	}
+	esl::database::SQLiteConnectionFactory::Settings connectionFactorySettings(settings);
+	sqlite4esl::database::ConnectionFactory connectionFactory(connectionFactorySettings);
+	std::unique_ptr<esl::database::Connection> connection = connectionFactory.createConnection();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	sqlite4esl::database::StatementHandle statementHandle = static_cast<sqlite4esl::database::Connection&>(*connection).prepareSQLite("SELECT count(*), sum(length(t)), sum(x) FROM t");
+	statementHandle.step();
+	std::chrono::steady_clock::duration duration = std::chrono::steady_clock::now() - start;
+
+	std::uint64_t bytes = 0;
+	for(const auto& ioStatistics : connectionFactory.getIoStatistics()) {
+		bytes += ioStatistics.second.reads.bytes;
+	}
+
+	std::cout << label << ": "
+			<< sqlite3_column_int64(&statementHandle.getHandle(), 0) << " rows in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << " ms, "
+			<< bytes << " bytes read\n";
+}
+
+} /* anonymous namespace */
+
+int main(int argc, const char* argv[]) {
+	long rows = argc > 1 ? std::atol(argv[1]) : 300000;
+	std::string directory = argc > 2 ? argv[2] : ".";
+	std::string plainFile = directory + "/sqlite4esl-benchmark.db";
+	std::string compressedFile = directory + "/sqlite4esl-benchmark.db.z";
+
+	try {
+		if(!sqlite4esl::database::CompressedVfs::isAvailable()) {
+			std::cerr << "sqlite4esl is built without zlib\n";
+			return 1;
+		}
+
+		createDatabase(plainFile, rows);
+		sqlite4esl::database::CompressedVfs::Statistics statistics = sqlite4esl::database::CompressedVfs::compress(plainFile, compressedFile);
+		std::cout << "compressed " << statistics.pages << " pages from " << statistics.bytes << " to " << statistics.compressedBytes << " bytes\n";
+
+		scan("plain VFS", plainFile, false);
+		scan("compressed VFS", compressedFile, true);
+	}
+	catch(const std::exception& e) {
+		std::cerr << "Benchmark failed: " << e.what() << "\n";
+		return 1;
+	}
+
+	std::remove(plainFile.c_str());
+	std::remove(compressedFile.c_str());
+	return 0;
+}
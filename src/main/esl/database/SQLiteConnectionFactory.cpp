@@ -8,8 +8,60 @@ namespace esl {
 inline namespace v1_6 {
 namespace database {
 
+namespace {
+bool toBool(const std::string& key, const std::string& value) {
+	if(value == "true") {
+		return true;
+	}
+	if(value == "false") {
+		return false;
+	}
+	throw std::runtime_error("Invalid value \"" + value + "\" for parameter key \"" + key + "\" at SQLiteConnectionFactory");
+}
+
+int toInt(const std::string& key, const std::string& value, int minValue) {
+	int intValue = std::stoi(value);
+	if(intValue < minValue) {
+		throw std::runtime_error("Invalid value \"" + value + "\" for parameter key \"" + key + "\" at SQLiteConnectionFactory");
+	}
+	return intValue;
+}
+}
+
 SQLiteConnectionFactory::Settings::Settings(const std::vector<std::pair<std::string, std::string>>& settings) {
 	bool hasTimeoutMS = false;
+	bool hasMaxConnections = false;
+	bool hasSharedCache = false;
+	bool hasReadUncommitted = false;
+	bool hasQueryPlanCapture = false;
+	bool hasQueryPlanFullScanThreshold = false;
+	bool hasQueryPlanAutoIndexThreshold = false;
+	bool hasQueryPlanMaxStatements = false;
+	bool hasCheckpointIntervalMS = false;
+	bool hasCheckpointRestartPages = false;
+	bool hasCheckpointTruncatePages = false;
+	bool hasMaintenanceIntervalMS = false;
+	bool hasMaintenanceBudgetMS = false;
+	bool hasMaintenanceIdleDelayMS = false;
+	bool hasAnalysisLimit = false;
+	bool hasIncrementalVacuumPages = false;
+	bool hasPageCacheSlotSize = false;
+	bool hasPageCacheSlots = false;
+	bool hasLookasideSlotSize = false;
+	bool hasLookasideSlots = false;
+	bool hasCacheSize = false;
+	bool hasReadOnly = false;
+	bool hasImmutable = false;
+	bool hasMmapSize = false;
+	bool hasBulkBatchRows = false;
+	bool hasStatementTimeoutMS = false;
+	bool hasProgressInstructions = false;
+	bool hasChangeCapture = false;
+	bool hasChangeCaptureValues = false;
+	bool hasResultCacheSize = false;
+	bool hasVfs = false;
+	bool hasIoStatistics = false;
+	bool hasCompression = false;
 
 	for(const auto& setting : settings) {
 		if(setting.first == "URI") {
@@ -28,6 +80,247 @@ SQLiteConnectionFactory::Settings::Settings(const std::vector<std::pair<std::str
 			hasTimeoutMS = true;
 			timeoutMS = std::stoi(setting.second);
 		}
+		else if(setting.first == "maxConnections") {
+			if(hasMaxConnections) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasMaxConnections = true;
+			maxConnections = toInt(setting.first, setting.second, 1);
+		}
+		else if(setting.first == "sharedCache") {
+			if(hasSharedCache) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasSharedCache = true;
+			sharedCache = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "readUncommitted") {
+			if(hasReadUncommitted) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasReadUncommitted = true;
+			readUncommitted = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "queryPlanCapture") {
+			if(hasQueryPlanCapture) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasQueryPlanCapture = true;
+			queryPlanCapture = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "queryPlanFullScanThreshold") {
+			if(hasQueryPlanFullScanThreshold) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasQueryPlanFullScanThreshold = true;
+			queryPlanFullScanThreshold = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "queryPlanAutoIndexThreshold") {
+			if(hasQueryPlanAutoIndexThreshold) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasQueryPlanAutoIndexThreshold = true;
+			queryPlanAutoIndexThreshold = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "queryPlanMaxStatements") {
+			if(hasQueryPlanMaxStatements) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasQueryPlanMaxStatements = true;
+			queryPlanMaxStatements = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "checkpointInterval") {
+			if(hasCheckpointIntervalMS) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasCheckpointIntervalMS = true;
+			checkpointIntervalMS = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "checkpointRestartPages") {
+			if(hasCheckpointRestartPages) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasCheckpointRestartPages = true;
+			checkpointRestartPages = toInt(setting.first, setting.second, 1);
+		}
+		else if(setting.first == "checkpointTruncatePages") {
+			if(hasCheckpointTruncatePages) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasCheckpointTruncatePages = true;
+			checkpointTruncatePages = toInt(setting.first, setting.second, 1);
+		}
+		else if(setting.first == "maintenanceInterval") {
+			if(hasMaintenanceIntervalMS) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasMaintenanceIntervalMS = true;
+			maintenanceIntervalMS = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "maintenanceBudget") {
+			if(hasMaintenanceBudgetMS) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasMaintenanceBudgetMS = true;
+			maintenanceBudgetMS = toInt(setting.first, setting.second, 1);
+		}
+		else if(setting.first == "maintenanceIdleDelay") {
+			if(hasMaintenanceIdleDelayMS) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasMaintenanceIdleDelayMS = true;
+			maintenanceIdleDelayMS = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "analysisLimit") {
+			if(hasAnalysisLimit) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasAnalysisLimit = true;
+			analysisLimit = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "incrementalVacuumPages") {
+			if(hasIncrementalVacuumPages) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasIncrementalVacuumPages = true;
+			incrementalVacuumPages = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "pageCacheSlotSize") {
+			if(hasPageCacheSlotSize) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasPageCacheSlotSize = true;
+			pageCacheSlotSize = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "pageCacheSlots") {
+			if(hasPageCacheSlots) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasPageCacheSlots = true;
+			pageCacheSlots = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "lookasideSlotSize") {
+			if(hasLookasideSlotSize) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasLookasideSlotSize = true;
+			lookasideSlotSize = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "lookasideSlots") {
+			if(hasLookasideSlots) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasLookasideSlots = true;
+			lookasideSlots = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "cacheSize") {
+			if(hasCacheSize) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasCacheSize = true;
+			cacheSize = std::stoi(setting.second);
+		}
+		else if(setting.first == "readOnly") {
+			if(hasReadOnly) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasReadOnly = true;
+			readOnly = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "immutable") {
+			if(hasImmutable) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasImmutable = true;
+			immutable = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "mmapSize") {
+			if(hasMmapSize) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasMmapSize = true;
+			if(setting.second == "auto") {
+				mmapSize = -1;
+			}
+			else {
+				mmapSize = std::stoll(setting.second);
+				if(mmapSize < 0) {
+					throw std::runtime_error("Invalid value \"" + setting.second + "\" for parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+				}
+			}
+		}
+		else if(setting.first == "bulkBatchRows") {
+			if(hasBulkBatchRows) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasBulkBatchRows = true;
+			bulkBatchRows = toInt(setting.first, setting.second, 1);
+		}
+		else if(setting.first == "statementTimeout") {
+			if(hasStatementTimeoutMS) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasStatementTimeoutMS = true;
+			statementTimeoutMS = toInt(setting.first, setting.second, 0);
+		}
+		else if(setting.first == "progressInstructions") {
+			if(hasProgressInstructions) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasProgressInstructions = true;
+			progressInstructions = toInt(setting.first, setting.second, 1);
+		}
+		else if(setting.first == "changeCapture") {
+			if(hasChangeCapture) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasChangeCapture = true;
+			changeCapture = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "changeCaptureValues") {
+			if(hasChangeCaptureValues) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasChangeCaptureValues = true;
+			changeCaptureValues = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "resultCacheSize") {
+			if(hasResultCacheSize) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasResultCacheSize = true;
+			resultCacheSize = std::stoll(setting.second);
+			if(resultCacheSize < 0) {
+				throw std::runtime_error("Invalid value \"" + setting.second + "\" for parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+		}
+		else if(setting.first == "vfs") {
+			if(hasVfs) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasVfs = true;
+			vfs = setting.second;
+		}
+		else if(setting.first == "ioStatistics") {
+			if(hasIoStatistics) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasIoStatistics = true;
+			ioStatistics = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "compression") {
+			if(hasCompression) {
+				throw std::runtime_error("Multiple definition of parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hasCompression = true;
+			compression = toBool(setting.first, setting.second);
+		}
+		else if(setting.first == "hotStatement") {
+			if(setting.second.empty()) {
+				throw std::runtime_error("Invalid value \"\" for parameter key \"" + setting.first + "\" at SQLiteConnectionFactory");
+			}
+			hotStatements.push_back(setting.second);
+		}
 		else {
 			throw std::runtime_error("Key \"" + setting.first + "\" is unknown at SQLiteConnectionFactory");
 		}
@@ -36,6 +329,34 @@ SQLiteConnectionFactory::Settings::Settings(const std::vector<std::pair<std::str
 	if(uri.empty()) {
 		throw std::runtime_error("Key \"URI\" is missing at SQLiteConnectionFactory");
 	}
+
+	if((pageCacheSlotSize > 0) != (pageCacheSlots > 0)) {
+		throw std::runtime_error("Keys \"pageCacheSlotSize\" and \"pageCacheSlots\" must be defined together at SQLiteConnectionFactory");
+	}
+
+	if((lookasideSlotSize > 0) != (lookasideSlots > 0)) {
+		throw std::runtime_error("Keys \"lookasideSlotSize\" and \"lookasideSlots\" must be defined together at SQLiteConnectionFactory");
+	}
+
+	if(immutable && !readOnly) {
+		throw std::runtime_error("Key \"immutable\" requires \"readOnly\" at SQLiteConnectionFactory");
+	}
+
+	if(compression && !readOnly) {
+		throw std::runtime_error("Key \"compression\" requires \"readOnly\" at SQLiteConnectionFactory");
+	}
+
+	if(readOnly && checkpointIntervalMS > 0) {
+		throw std::runtime_error("Key \"checkpointInterval\" cannot be used with \"readOnly\" at SQLiteConnectionFactory");
+	}
+
+	if(readOnly && maintenanceIntervalMS > 0) {
+		throw std::runtime_error("Key \"maintenanceInterval\" cannot be used with \"readOnly\" at SQLiteConnectionFactory");
+	}
+
+	if(maxConnections > 1 && uri == ":memory:") {
+		throw std::runtime_error("URI \"" + uri + "\" opens a private database per handle, use \"file:<name>?mode=memory&cache=shared\" for \"maxConnections\" > 1 at SQLiteConnectionFactory");
+	}
 }
 
 SQLiteConnectionFactory::SQLiteConnectionFactory(const Settings& settings)
@@ -4,6 +4,7 @@
 #include <esl/database/Connection.h>
 #include <esl/database/ConnectionFactory.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -20,6 +21,109 @@ public:
 
 		std::string uri;
 		int timeoutMS = 10000;
+
+		/* Maximum number of sqlite3 handles opened by the factory. With more than one
+		 * handle every connection gets an exclusive handle. Several handles on one
+		 * in-memory database require a named shared cache URI, e.g.
+		 * "file:name?mode=memory&cache=shared". */
+		int maxConnections = 1;
+		bool sharedCache = false;
+		bool readUncommitted = false;
+
+		/* Records EXPLAIN QUERY PLAN once per distinct SQL and flags statements whose
+		 * full scan steps or rows inserted into automatic indexes within a single
+		 * execution reach the thresholds (0 disables a threshold). Plans are kept for the
+		 * lifetime of the factory, statements with SQL beyond the first
+		 * "queryPlanMaxStatements" distinct SQL are not recorded (0 for no limit). */
+		bool queryPlanCapture = false;
+		int queryPlanFullScanThreshold = 1000;
+		int queryPlanAutoIndexThreshold = 1;
+		int queryPlanMaxStatements = 1000;
+
+		/* Runs WAL checkpoints on a background thread with its own handle instead of
+		 * inline on the committing writer. A PASSIVE checkpoint runs every interval,
+		 * RESTART or TRUNCATE once the WAL has grown to the given number of pages.
+		 * 0 disables the scheduler. */
+		int checkpointIntervalMS = 0;
+		int checkpointRestartPages = 4000;
+		int checkpointTruncatePages = 16000;
+
+		/* Runs PRAGMA optimize and incremental vacuum on a background thread (see
+		 * sqlite4esl::database::MaintenanceScheduler) and PRAGMA optimize before a handle
+		 * is closed. Every run is interrupted after "maintenanceBudget". Incremental vacuum
+		 * frees up to "incrementalVacuumPages" pages per step once no connection has been
+		 * in use for "maintenanceIdleDelay". 0 disables the scheduler. */
+		int maintenanceIntervalMS = 0;
+		int maintenanceBudgetMS = 50;
+		int maintenanceIdleDelayMS = 1000;
+		/* PRAGMA analysis_limit, i.e. rows ANALYZE examines per index, 0 is unlimited */
+		int analysisLimit = 400;
+		int incrementalVacuumPages = 64;
+
+		/* Preallocated slab for the page cache of all handles (SQLITE_CONFIG_PAGECACHE).
+		 * This is a process wide setting and only applied if sqlite3 has not been
+		 * initialized yet. A slot should hold a page plus about 256 bytes of header. */
+		int pageCacheSlotSize = 0;
+		int pageCacheSlots = 0;
+
+		/* Lookaside allocator of every handle (SQLITE_DBCONFIG_LOOKASIDE) */
+		int lookasideSlotSize = 0;
+		int lookasideSlots = 0;
+
+		/* PRAGMA cache_size of every handle, negative values are KiB. 0 keeps the default. */
+		int cacheSize = 0;
+
+		/* Read optimized mode: handles are opened with SQLITE_OPEN_READONLY. "immutable"
+		 * additionally opens the file with the URI parameter immutable=1, so sqlite3
+		 * skips locking and change detection. Use it only for files that never change. */
+		bool readOnly = false;
+		bool immutable = false;
+
+		/* PRAGMA mmap_size of every handle in bytes. "auto" (-1) maps the whole file,
+		 * i.e. page_count * page_size at the time the handle is opened. The value is
+		 * capped by SQLITE_MAX_MMAP_SIZE of the sqlite3 library. Pooled handles map the
+		 * same file MAP_SHARED, so they share the pages of the OS page cache. */
+		std::int64_t mmapSize = 0;
+
+		/* Within a transaction bulk statements of the form "INSERT ... VALUES (?, ...)"
+		 * buffer rows and insert them with one statement of up to this many rows (capped by
+		 * SQLITE_LIMIT_VARIABLE_NUMBER). Buffered rows are written when the batch is full,
+		 * before any other statement of the connection is stepped and on commit, so errors
+		 * of a row may be reported by a later call. Rows that cannot be written when the bulk
+		 * statement is destroyed make the commit fail. Outside of a transaction rows are
+		 * written immediately. 1 disables batching. */
+		int bulkBatchRows = 1;
+
+		/* Statements prepared with SQLITE_PREPARE_PERSISTENT on every handle when it is
+		 * opened and kept pinned. Key "hotStatement" may be given several times. */
+		std::vector<std::string> hotStatements;
+
+		/* Default deadline of a statement from its first step, 0 disables it. A progress
+		 * handler checks deadlines and cancellation every "progressInstructions" virtual
+		 * machine instructions. */
+		int statementTimeoutMS = 0;
+		int progressInstructions = 1000;
+
+		/* Records the changes of every handle and publishes them per committed
+		 * transaction (see ConnectionFactory::subscribeChanges()). "changeCaptureValues"
+		 * adds old and new column values, if sqlite3 has SQLITE_ENABLE_PREUPDATE_HOOK. */
+		bool changeCapture = false;
+		bool changeCaptureValues = false;
+
+		/* Bytes of materialized results of read only prepared statements, 0 disables the
+		 * cache. Results are invalidated when a transaction writing to one of their tables
+		 * commits on a handle of this factory (see ResultCache). */
+		std::int64_t resultCacheSize = 0;
+
+		/* Name of the VFS used to open the handles, empty for the default VFS.
+		 * "ioStatistics" wraps it into a shim that records per file I/O statistics (see
+		 * ConnectionFactory::getIoStatistics()). */
+		std::string vfs;
+		bool ioStatistics = false;
+
+		/* Reads databases written by sqlite4esl::database::CompressedVfs::compress(), plain
+		 * databases are opened as usual. Requires "readOnly". */
+		bool compression = false;
 	};
 
 	SQLiteConnectionFactory(const Settings& settings);
@@ -0,0 +1,69 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/CachedResultSetBinding.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <stdexcept>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+CachedResultSetBinding::CachedResultSetBinding(std::shared_ptr<const ResultCache::Result> aResult, const std::vector<esl::database::Column>& resultColumns, std::unique_ptr<ResultSetBinding> aResultSetBinding)
+: esl::database::ResultSet::Binding(resultColumns),
+  result(std::move(aResult)),
+  resultSetBinding(std::move(aResultSetBinding))
+{ }
+
+bool CachedResultSetBinding::fetch(std::vector<esl::database::Field>& fields) {
+	if(fields.size() != getColumns().size()) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Called 'fetch' with wrong number of fields. Given " + std::to_string(fields.size()) + " fields, but it should be " + std::to_string(getColumns().size()) + " fields."));
+	}
+
+	if(nextRow < result->rows.size()) {
+		const ResultCache::Row& row = result->rows[nextRow++];
+		for(std::size_t i=0; i<fields.size(); ++i) {
+			fields[i] = row[i];
+		}
+		return true;
+	}
+
+	if(resultSetBinding) {
+		return resultSetBinding->fetch(fields);
+	}
+
+	return false;
+}
+
+bool CachedResultSetBinding::isEditable(std::size_t columnIndex) {
+	return false;
+}
+
+void CachedResultSetBinding::add(std::vector<esl::database::Field>& fields) {
+    throw esl::system::Stacktrace::add(std::runtime_error("add not allowed for query result set."));
+}
+
+void CachedResultSetBinding::save(std::vector<esl::database::Field>& fields) {
+    throw esl::system::Stacktrace::add(std::runtime_error("save not allowed for query result set."));
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
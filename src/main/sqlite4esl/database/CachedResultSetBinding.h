@@ -0,0 +1,57 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_CACHEDRESULTSETBINDING_H_
+#define SQLITE4ESL_DATABASE_CACHEDRESULTSETBINDING_H_
+
+#include <sqlite4esl/database/ResultCache.h>
+#include <sqlite4esl/database/ResultSetBinding.h>
+
+#include <esl/database/ResultSet.h>
+#include <esl/database/Column.h>
+#include <esl/database/Field.h>
+
+#include <memory>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Serves the rows of a materialized result. If "resultSetBinding" is given, its
+ * remaining rows follow, e.g. for results that are too large to be cached. */
+class CachedResultSetBinding : public esl::database::ResultSet::Binding {
+public:
+	CachedResultSetBinding(std::shared_ptr<const ResultCache::Result> result, const std::vector<esl::database::Column>& resultColumns, std::unique_ptr<ResultSetBinding> resultSetBinding = nullptr);
+
+	bool fetch(std::vector<esl::database::Field>& fields) override;
+	bool isEditable(std::size_t columnIndex) override;
+	void add(std::vector<esl::database::Field>& fields) override;
+	void save(std::vector<esl::database::Field>& fields) override;
+
+private:
+	std::shared_ptr<const ResultCache::Result> result;
+	std::size_t nextRow = 0;
+	std::unique_ptr<ResultSetBinding> resultSetBinding;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_CACHEDRESULTSETBINDING_H_ */
@@ -0,0 +1,39 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/CancellationToken.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+CancellationToken::CancellationToken()
+: cancelled(std::make_shared<std::atomic<bool>>(false))
+{ }
+
+void CancellationToken::cancel() noexcept {
+	cancelled->store(true);
+}
+
+bool CancellationToken::isCancelled() const noexcept {
+	return cancelled->load(std::memory_order_relaxed);
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,288 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/ChangeCapture.h>
+#include <sqlite4esl/database/Value.h>
+
+#include <esl/Logger.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::ChangeCapture");
+
+/* the authorizer is called on the thread that compiles the statement */
+thread_local int previousAuthorizerAction = 0;
+
+Change::Operation toOperation(int operation) {
+	switch(operation) {
+	case SQLITE_INSERT:
+		return Change::Operation::insert;
+	case SQLITE_DELETE:
+		return Change::Operation::remove;
+	default:
+		return Change::Operation::update;
+	}
+}
+}
+
+ChangeCapture::Recorder::Recorder(ChangeCapture& aChangeCapture, sqlite3& aConnectionHandle, bool aCaptureChanges, bool captureValues)
+: changeCapture(aChangeCapture),
+  connectionHandle(aConnectionHandle),
+  captureChanges(aCaptureChanges)
+{
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+	if(captureChanges && captureValues) {
+		sqlite3_preupdate_hook(&connectionHandle, preupdateHook, this);
+	}
+	else {
+		sqlite3_update_hook(&connectionHandle, updateHook, this);
+	}
+#else
+	if(captureChanges && captureValues) {
+		logger.warn << "Values of changes are not captured, because sqlite3 is compiled without SQLITE_ENABLE_PREUPDATE_HOOK\n";
+	}
+	sqlite3_update_hook(&connectionHandle, updateHook, this);
+#endif
+	sqlite3_commit_hook(&connectionHandle, commitHook, this);
+	sqlite3_rollback_hook(&connectionHandle, rollbackHook, this);
+	sqlite3_set_authorizer(&connectionHandle, authorize, nullptr);
+}
+
+ChangeCapture::Recorder::~Recorder() {
+	sqlite3_update_hook(&connectionHandle, nullptr, nullptr);
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+	sqlite3_preupdate_hook(&connectionHandle, nullptr, nullptr);
+#endif
+	sqlite3_commit_hook(&connectionHandle, nullptr, nullptr);
+	sqlite3_rollback_hook(&connectionHandle, nullptr, nullptr);
+	sqlite3_set_authorizer(&connectionHandle, nullptr, nullptr);
+}
+
+int ChangeCapture::Recorder::authorize(void*, int action, const char* table, const char*, const char*, const char*) {
+	int previousAction = previousAuthorizerAction;
+	previousAuthorizerAction = action;
+
+	/* DROP TABLE and DROP VIEW check SQLITE_DELETE on the schema table and on the dropped
+	 * table as well, SQLITE_IGNORE would skip them */
+	if(action != SQLITE_DELETE || table == nullptr || sqlite3_strnicmp(table, "sqlite_", 7) == 0) {
+		return SQLITE_OK;
+	}
+	switch(previousAction) {
+	case SQLITE_DROP_TABLE:
+	case SQLITE_DROP_TEMP_TABLE:
+	case SQLITE_DROP_VIEW:
+	case SQLITE_DROP_TEMP_VIEW:
+		return SQLITE_OK;
+	default:
+		return SQLITE_IGNORE;
+	}
+}
+
+void ChangeCapture::Recorder::publishCommitted() {
+	if(committedTables.empty() || sqlite3_get_autocommit(&connectionHandle) == 0) {
+		return;
+	}
+
+	std::vector<Change> changes;
+	std::vector<std::string> tables;
+	changes.swap(committed);
+	tables.swap(committedTables);
+	changeCapture.publish(changes, tables);
+}
+
+void ChangeCapture::Recorder::updateHook(void* recorderPtr, int operation, const char* database, const char* table, sqlite3_int64 rowid) {
+	Recorder& recorder = *static_cast<Recorder*>(recorderPtr);
+
+	recorder.addTable(database, table);
+	if(!recorder.captureChanges) {
+		return;
+	}
+
+	recorder.pending.emplace_back();
+	Change& change = recorder.pending.back();
+	change.database = database;
+	change.table = table;
+	change.operation = toOperation(operation);
+	change.rowid = rowid;
+	change.newRowid = rowid;
+}
+
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+void ChangeCapture::Recorder::preupdateHook(void* recorderPtr, sqlite3* connectionHandle, int operation, const char* database, const char* table, sqlite3_int64 rowid, sqlite3_int64 newRowid) {
+	Recorder& recorder = *static_cast<Recorder*>(recorderPtr);
+
+	recorder.addTable(database, table);
+
+	recorder.pending.emplace_back();
+	Change& change = recorder.pending.back();
+	change.database = database;
+	change.table = table;
+	change.operation = toOperation(operation);
+	change.rowid = rowid;
+	change.newRowid = newRowid;
+
+	int columnCount = sqlite3_preupdate_count(connectionHandle);
+	for(int i = 0; i < columnCount; ++i) {
+		sqlite3_value* value = nullptr;
+		if(operation != SQLITE_INSERT && sqlite3_preupdate_old(connectionHandle, i, &value) == SQLITE_OK && value) {
+			change.oldValues.push_back(Value<esl::database::Field>::get(*value));
+		}
+		value = nullptr;
+		if(operation != SQLITE_DELETE && sqlite3_preupdate_new(connectionHandle, i, &value) == SQLITE_OK && value) {
+			change.newValues.push_back(Value<esl::database::Field>::get(*value));
+		}
+	}
+}
+#endif
+
+int ChangeCapture::Recorder::commitHook(void* recorderPtr) {
+	Recorder& recorder = *static_cast<Recorder*>(recorderPtr);
+
+	/* the commit may still fail, e.g. with SQLITE_BUSY, so changes are published after
+	 * the handle has left the transaction */
+	if(recorder.committed.empty()) {
+		recorder.committed.swap(recorder.pending);
+	}
+	else {
+		recorder.committed.insert(recorder.committed.end(), recorder.pending.begin(), recorder.pending.end());
+		recorder.pending.clear();
+	}
+
+	for(const auto& table : recorder.pendingTables) {
+		if(std::find(recorder.committedTables.begin(), recorder.committedTables.end(), table) == recorder.committedTables.end()) {
+			recorder.committedTables.push_back(table);
+		}
+	}
+	recorder.pendingTables.clear();
+
+	return 0;
+}
+
+void ChangeCapture::Recorder::rollbackHook(void* recorderPtr) {
+	Recorder& recorder = *static_cast<Recorder*>(recorderPtr);
+	recorder.pending.clear();
+	recorder.committed.clear();
+	recorder.pendingTables.clear();
+	recorder.committedTables.clear();
+}
+
+void ChangeCapture::Recorder::addTable(const char* database, const char* table) {
+	/* rows of a transaction are mostly written to few tables, most recent first */
+	std::size_t databaseLength = std::strlen(database);
+	for(auto iter = pendingTables.rbegin(); iter != pendingTables.rend(); ++iter) {
+		if(iter->size() > databaseLength && iter->compare(0, databaseLength, database) == 0
+				&& (*iter)[databaseLength] == '.' && iter->compare(databaseLength + 1, std::string::npos, table) == 0) {
+			return;
+		}
+	}
+
+	pendingTables.push_back(std::string(database) + "." + table);
+}
+
+std::size_t ChangeCapture::subscribe(Subscriber subscriber) {
+	std::lock_guard<std::mutex> lock(subscribersMutex);
+
+	std::size_t id = nextId++;
+	subscribers.emplace_back(id, std::make_shared<Subscriber>(std::move(subscriber)));
+	return id;
+}
+
+void ChangeCapture::unsubscribe(std::size_t id) {
+	std::lock_guard<std::mutex> lock(subscribersMutex);
+
+	for(auto iter = subscribers.begin(); iter != subscribers.end(); ++iter) {
+		if(iter->first == id) {
+			subscribers.erase(iter);
+			return;
+		}
+	}
+	for(auto iter = tableSubscribers.begin(); iter != tableSubscribers.end(); ++iter) {
+		if(iter->first == id) {
+			tableSubscribers.erase(iter);
+			return;
+		}
+	}
+}
+
+std::size_t ChangeCapture::subscribeTables(TableSubscriber subscriber) {
+	std::lock_guard<std::mutex> lock(subscribersMutex);
+
+	std::size_t id = nextId++;
+	tableSubscribers.emplace_back(id, std::make_shared<TableSubscriber>(std::move(subscriber)));
+	return id;
+}
+
+bool ChangeCapture::isValueCaptureAvailable() noexcept {
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ChangeCapture::publish(const std::vector<Change>& changes, const std::vector<std::string>& tables) {
+	std::vector<std::shared_ptr<TableSubscriber>> currentTableSubscribers;
+	std::vector<std::shared_ptr<Subscriber>> currentSubscribers;
+	{
+		std::lock_guard<std::mutex> lock(subscribersMutex);
+		for(const auto& subscriber : tableSubscribers) {
+			currentTableSubscribers.push_back(subscriber.second);
+		}
+		if(!changes.empty()) {
+			for(const auto& subscriber : subscribers) {
+				currentSubscribers.push_back(subscriber.second);
+			}
+		}
+	}
+
+	/* subscribers are called without lock, so they may subscribe or unsubscribe */
+	for(const auto& subscriber : currentTableSubscribers) {
+		try {
+			(*subscriber)(tables);
+		}
+		catch(const std::exception& e) {
+			logger.warn << "Table subscriber failed: " << e.what() << "\n";
+		}
+		catch(...) {
+			logger.warn << "Table subscriber failed with unknown exception\n";
+		}
+	}
+
+	for(const auto& subscriber : currentSubscribers) {
+		try {
+			(*subscriber)(changes);
+		}
+		catch(const std::exception& e) {
+			logger.warn << "Change subscriber failed: " << e.what() << "\n";
+		}
+		catch(...) {
+			logger.warn << "Change subscriber failed with unknown exception\n";
+		}
+	}
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
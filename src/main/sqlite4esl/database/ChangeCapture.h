@@ -0,0 +1,134 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_CHANGECAPTURE_H_
+#define SQLITE4ESL_DATABASE_CHANGECAPTURE_H_
+
+#include <esl/database/Field.h>
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+struct Change {
+	enum class Operation {
+		insert,
+		update,
+		remove
+	};
+
+	std::string database;
+	std::string table;
+	Operation operation;
+	std::int64_t rowid;
+	/* differs from "rowid" if an update changed the rowid */
+	std::int64_t newRowid;
+
+	/* Only filled if values are captured, which requires sqlite3 with
+	 * SQLITE_ENABLE_PREUPDATE_HOOK. "oldValues" is empty for inserts, "newValues"
+	 * for deletes. */
+	std::vector<esl::database::Field> oldValues;
+	std::vector<esl::database::Field> newValues;
+};
+
+/* Publishes the changes of every committed transaction as one batch to the
+ * subscribers. Changes are recorded per handle with sqlite3_update_hook (or
+ * sqlite3_preupdate_hook if values are captured), collected on commit and dropped on
+ * rollback. A batch is published on the committing thread after the statement that
+ * committed has returned.
+ * Changes of WITHOUT ROWID tables are only reported with the preupdate hook and changes
+ * undone by ROLLBACK TO a savepoint are reported nevertheless. "DELETE FROM <table>"
+ * without WHERE deletes row by row instead of truncating, so every row is reported. */
+class ChangeCapture {
+public:
+	using Subscriber = std::function<void(const std::vector<Change>&)>;
+	/* Gets the tables ("<database>.<table>") written by a committed transaction */
+	using TableSubscriber = std::function<void(const std::vector<std::string>&)>;
+
+	/* Records the changes of one handle, used only by the thread that uses the handle */
+	class Recorder {
+	public:
+		/* Without "captureChanges" only the written tables are recorded */
+		Recorder(ChangeCapture& changeCapture, sqlite3& connectionHandle, bool captureChanges, bool captureValues);
+		Recorder(const Recorder&) = delete;
+		~Recorder();
+
+		Recorder& operator=(const Recorder&) = delete;
+
+		/* Publishes the committed changes, if the handle is not in a transaction anymore */
+		void publishCommitted();
+
+		/* Authorizer installed on the handle. It disables the truncate optimization of
+		 * "DELETE FROM <table>", which deletes all rows without calling the update hook.
+		 * Code that replaces the authorizer temporarily has to install it again. */
+		static int authorize(void*, int action, const char* table, const char*, const char*, const char*);
+
+	private:
+		static void updateHook(void* recorder, int operation, const char* database, const char* table, sqlite3_int64 rowid);
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+		static void preupdateHook(void* recorder, sqlite3* connectionHandle, int operation, const char* database, const char* table, sqlite3_int64 rowid, sqlite3_int64 newRowid);
+#endif
+		static int commitHook(void* recorder);
+		static void rollbackHook(void* recorder);
+
+		void addTable(const char* database, const char* table);
+
+		ChangeCapture& changeCapture;
+		sqlite3& connectionHandle;
+		bool captureChanges;
+		std::vector<Change> pending;
+		std::vector<Change> committed;
+		std::vector<std::string> pendingTables;
+		std::vector<std::string> committedTables;
+	};
+
+	/* Returns an id for unsubscribe() */
+	std::size_t subscribe(Subscriber subscriber);
+	void unsubscribe(std::size_t id);
+
+	/* Table subscribers are called before the change subscribers */
+	std::size_t subscribeTables(TableSubscriber subscriber);
+
+	/* true if sqlite3 is compiled with SQLITE_ENABLE_PREUPDATE_HOOK */
+	static bool isValueCaptureAvailable() noexcept;
+
+private:
+	void publish(const std::vector<Change>& changes, const std::vector<std::string>& tables);
+
+	std::mutex subscribersMutex;
+	std::size_t nextId = 1;
+	std::vector<std::pair<std::size_t, std::shared_ptr<Subscriber>>> subscribers;
+	std::vector<std::pair<std::size_t, std::shared_ptr<TableSubscriber>>> tableSubscribers;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_CHANGECAPTURE_H_ */
@@ -0,0 +1,170 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/CheckpointScheduler.h>
+
+#include <esl/Logger.h>
+
+#include <algorithm>
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::CheckpointScheduler");
+}
+
+CheckpointScheduler::CheckpointScheduler(sqlite3& aConnectionHandle, std::chrono::milliseconds aInterval, std::uint64_t aRestartPages, std::uint64_t aTruncatePages, std::chrono::milliseconds aBusyTimeout)
+: connectionHandle(aConnectionHandle),
+  interval(aInterval),
+  restartPages(aRestartPages),
+  truncatePages(aTruncatePages),
+  busyTimeout(aBusyTimeout)
+{
+	/* RESTART and TRUNCATE wait for readers by the busy handler */
+	sqlite3_busy_timeout(&connectionHandle, static_cast<int>(busyTimeout.count()));
+
+	sqlite3_stmt* stmt = nullptr;
+	if(sqlite3_prepare_v2(&connectionHandle, "PRAGMA journal_mode;", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+		const char* journalMode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+		if(journalMode == nullptr || std::string(journalMode) != "wal") {
+			logger.warn << "Checkpoint scheduler is enabled, but journal mode is \"" << (journalMode ? journalMode : "") << "\" instead of \"wal\"\n";
+		}
+	}
+	sqlite3_finalize(stmt);
+
+	thread = std::thread(&CheckpointScheduler::run, this);
+}
+
+CheckpointScheduler::~CheckpointScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	condition.notify_all();
+	thread.join();
+}
+
+void CheckpointScheduler::install(sqlite3& aConnectionHandle) {
+	/* replaces the automatic checkpoint hook of sqlite3_wal_autocheckpoint */
+	sqlite3_wal_hook(&aConnectionHandle, walHook, this);
+
+	/* writers wait while a RESTART or TRUNCATE checkpoint holds the write lock */
+	sqlite3_busy_timeout(&aConnectionHandle, static_cast<int>(busyTimeout.count()));
+}
+
+CheckpointScheduler::Statistics CheckpointScheduler::getStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	Statistics result = statistics;
+	result.walPages = walPages.load(std::memory_order_relaxed);
+	return result;
+}
+
+int CheckpointScheduler::walHook(void* checkpointSchedulerPtr, sqlite3*, const char*, int walPages) {
+	CheckpointScheduler& checkpointScheduler = *static_cast<CheckpointScheduler*>(checkpointSchedulerPtr);
+	std::uint64_t pages = walPages > 0 ? static_cast<std::uint64_t>(walPages) : 0;
+
+	checkpointScheduler.walPages.store(pages, std::memory_order_relaxed);
+	if(pages >= checkpointScheduler.restartPages) {
+		/* escalate without waiting for the next interval */
+		checkpointScheduler.escalate.store(true, std::memory_order_relaxed);
+		checkpointScheduler.condition.notify_one();
+	}
+
+	return SQLITE_OK;
+}
+
+void CheckpointScheduler::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while(!stopped) {
+		condition.wait_for(lock, interval, [this] {
+			return stopped || escalate.load(std::memory_order_relaxed);
+		});
+		if(stopped) {
+			break;
+		}
+		escalate.store(false, std::memory_order_relaxed);
+
+		lock.unlock();
+		checkpoint();
+		lock.lock();
+	}
+}
+
+void CheckpointScheduler::checkpoint() {
+	std::uint64_t pages = walPages.load(std::memory_order_relaxed);
+	if(pages == 0) {
+		return;
+	}
+
+	int mode = SQLITE_CHECKPOINT_PASSIVE;
+	if(pages >= truncatePages) {
+		mode = SQLITE_CHECKPOINT_TRUNCATE;
+	}
+	else if(pages >= restartPages) {
+		mode = SQLITE_CHECKPOINT_RESTART;
+	}
+
+	int logFrames = 0;
+	int checkpointedFrames = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int rc = sqlite3_wal_checkpoint_v2(&connectionHandle, nullptr, mode, &logFrames, &checkpointedFrames);
+	std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	if(rc == SQLITE_OK && (mode != SQLITE_CHECKPOINT_PASSIVE || logFrames == checkpointedFrames)) {
+		/* After RESTART the next writer starts the WAL from the beginning, so until then
+		 * nothing is left to checkpoint. After PASSIVE the frames stay in the WAL. */
+		walPages.store(mode == SQLITE_CHECKPOINT_PASSIVE ? static_cast<std::uint64_t>(std::max(logFrames, 0)) : 0, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	statistics.maxWalPages = std::max(statistics.maxWalPages, pages);
+	statistics.lastDuration = duration;
+	statistics.maxDuration = std::max(statistics.maxDuration, duration);
+	statistics.totalDuration += duration;
+
+	switch(rc & 0xff) {
+	case SQLITE_OK:
+		switch(mode) {
+		case SQLITE_CHECKPOINT_TRUNCATE:
+			++statistics.truncateCheckpoints;
+			break;
+		case SQLITE_CHECKPOINT_RESTART:
+			++statistics.restartCheckpoints;
+			break;
+		default:
+			++statistics.passiveCheckpoints;
+			break;
+		}
+		break;
+	case SQLITE_BUSY:
+		++statistics.busyCheckpoints;
+		break;
+	default:
+		++statistics.failedCheckpoints;
+		logger.warn << "WAL checkpoint failed: " << sqlite3_errmsg(&connectionHandle) << "\n";
+		break;
+	}
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
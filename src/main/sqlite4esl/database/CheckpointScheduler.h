@@ -0,0 +1,95 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_CHECKPOINTSCHEDULER_H_
+#define SQLITE4ESL_DATABASE_CHECKPOINTSCHEDULER_H_
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Runs WAL checkpoints on a background thread. install() replaces the automatic
+ * checkpoint of a handle by a WAL hook that only records the size of the WAL, so
+ * committing writers never run a checkpoint inline. It also sets the busy timeout
+ * of the handle, because RESTART and TRUNCATE block writers while they wait for
+ * readers. */
+class CheckpointScheduler {
+public:
+	struct Statistics {
+		/* WAL size in pages as reported by the last commit or checkpoint */
+		std::uint64_t walPages = 0;
+		std::uint64_t maxWalPages = 0;
+
+		std::uint64_t passiveCheckpoints = 0;
+		std::uint64_t restartCheckpoints = 0;
+		std::uint64_t truncateCheckpoints = 0;
+		/* checkpoints that could not complete because of readers or writers */
+		std::uint64_t busyCheckpoints = 0;
+		std::uint64_t failedCheckpoints = 0;
+
+		std::chrono::microseconds lastDuration{0};
+		std::chrono::microseconds maxDuration{0};
+		std::chrono::microseconds totalDuration{0};
+	};
+
+	/* "connectionHandle" is used by the checkpoint thread exclusively and must
+	 * outlive the scheduler */
+	CheckpointScheduler(sqlite3& connectionHandle, std::chrono::milliseconds interval, std::uint64_t restartPages, std::uint64_t truncatePages, std::chrono::milliseconds busyTimeout);
+	~CheckpointScheduler();
+
+	void install(sqlite3& connectionHandle);
+
+	Statistics getStatistics() const;
+
+private:
+	static int walHook(void* checkpointScheduler, sqlite3* connectionHandle, const char* databaseName, int walPages);
+
+	void run();
+	void checkpoint();
+
+	sqlite3& connectionHandle;
+	const std::chrono::milliseconds interval;
+	const std::uint64_t restartPages;
+	const std::uint64_t truncatePages;
+	const std::chrono::milliseconds busyTimeout;
+
+	std::atomic<std::uint64_t> walPages{0};
+	std::atomic<bool> escalate{false};
+
+	mutable std::mutex mutex;
+	std::condition_variable condition;
+	bool stopped = false;
+	Statistics statistics;
+
+	std::thread thread;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_CHECKPOINTSCHEDULER_H_ */
@@ -0,0 +1,604 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/CompressedVfs.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <esl/Logger.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <sqlite3.h>
+
+#ifdef SQLITE4ESL_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::CompressedVfs");
+
+#ifdef SQLITE4ESL_WITH_ZLIB
+const char magic[4] = { 'S', '4', 'E', 'Z' };
+const std::uint32_t formatVersion = 1;
+const std::size_t headerSize = 32;
+const std::size_t indexEntrySize = 16;
+/* index flag of pages stored uncompressed, because they did not get smaller */
+const std::uint32_t rawPage = 1;
+
+void encode32(unsigned char* data, std::uint32_t value) {
+	for(int i=0; i<4; ++i) {
+		data[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+}
+
+void encode64(unsigned char* data, std::uint64_t value) {
+	for(int i=0; i<8; ++i) {
+		data[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+}
+
+std::uint32_t decode32(const unsigned char* data) {
+	std::uint32_t value = 0;
+	for(int i=3; i>=0; --i) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+std::uint64_t decode64(const unsigned char* data) {
+	std::uint64_t value = 0;
+	for(int i=7; i>=0; --i) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+struct IndexEntry {
+	std::uint64_t offset;
+	std::uint32_t size;
+	std::uint32_t flags;
+};
+
+/* State of an open compressed database file, used by one handle at a time */
+struct Archive {
+	std::uint32_t pageSize = 0;
+	std::uint64_t fileSize = 0;
+	std::vector<IndexEntry> index;
+
+	std::size_t cachePages = 64;
+	/* most recently used first */
+	std::list<std::pair<std::uint64_t, std::string>> cache;
+	std::unordered_map<std::uint64_t, std::list<std::pair<std::uint64_t, std::string>>::iterator> cacheByPage;
+	std::vector<unsigned char> buffer;
+};
+
+struct CompressedFile {
+	sqlite3_file base;
+	Archive* archive;
+	sqlite3_file* realFile;
+};
+
+struct Vfs {
+	sqlite3_vfs vfs;
+	sqlite3_vfs* baseVfs;
+	std::string name;
+};
+
+std::mutex vfsMutex;
+/* VFS live until the process terminates, because sqlite3 keeps pointers */
+std::map<std::string, std::unique_ptr<Vfs>> vfsByBase;
+
+sqlite3_vfs& getBaseVfs(sqlite3_vfs* vfs) {
+	return *static_cast<Vfs*>(vfs->pAppData)->baseVfs;
+}
+
+CompressedFile& getCompressedFile(sqlite3_file* file) {
+	return *reinterpret_cast<CompressedFile*>(file);
+}
+
+int readReal(sqlite3_file& realFile, void* data, std::size_t size, std::uint64_t offset) {
+	return realFile.pMethods->xRead(&realFile, data, static_cast<int>(size), static_cast<sqlite3_int64>(offset));
+}
+
+/* Returns nullptr on error */
+const std::string* getPage(CompressedFile& compressedFile, std::uint64_t page) {
+	Archive& archive = *compressedFile.archive;
+
+	auto iter = archive.cacheByPage.find(page);
+	if(iter != archive.cacheByPage.end()) {
+		archive.cache.splice(archive.cache.begin(), archive.cache, iter->second);
+		return &iter->second->second;
+	}
+
+	const IndexEntry& indexEntry = archive.index[page];
+	archive.buffer.resize(indexEntry.size);
+	if(indexEntry.size > 0 && readReal(*compressedFile.realFile, archive.buffer.data(), indexEntry.size, indexEntry.offset) != SQLITE_OK) {
+		return nullptr;
+	}
+
+	std::string data;
+	if(indexEntry.flags & rawPage) {
+		data.assign(reinterpret_cast<const char*>(archive.buffer.data()), archive.buffer.size());
+	}
+	else {
+		data.resize(archive.pageSize);
+		uLongf size = archive.pageSize;
+		if(uncompress(reinterpret_cast<Bytef*>(&data[0]), &size, archive.buffer.data(), indexEntry.size) != Z_OK) {
+			return nullptr;
+		}
+		data.resize(size);
+	}
+
+	if(archive.cache.size() >= archive.cachePages && !archive.cache.empty()) {
+		archive.cacheByPage.erase(archive.cache.back().first);
+		archive.cache.pop_back();
+	}
+	archive.cache.emplace_front(page, std::move(data));
+	archive.cacheByPage[page] = archive.cache.begin();
+
+	return &archive.cache.front().second;
+}
+
+int compressedClose(sqlite3_file* file) {
+	CompressedFile& compressedFile = getCompressedFile(file);
+	int rc = compressedFile.realFile->pMethods->xClose(compressedFile.realFile);
+	delete compressedFile.archive;
+	compressedFile.archive = nullptr;
+	return rc;
+}
+
+int compressedRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset) {
+	CompressedFile& compressedFile = getCompressedFile(file);
+	Archive& archive = *compressedFile.archive;
+	unsigned char* output = static_cast<unsigned char*>(buffer);
+
+	try {
+		std::uint64_t position = static_cast<std::uint64_t>(offset);
+		std::uint64_t end = position + static_cast<std::uint64_t>(amount);
+		while(position < end && position < archive.fileSize) {
+			std::uint64_t page = position / archive.pageSize;
+			const std::string* data = getPage(compressedFile, page);
+			if(data == nullptr) {
+				return SQLITE_IOERR_READ;
+			}
+
+			std::uint64_t pageOffset = position - page * archive.pageSize;
+			std::uint64_t size = std::min<std::uint64_t>(end - position, archive.pageSize - pageOffset);
+			if(pageOffset + size > data->size()) {
+				return SQLITE_CORRUPT;
+			}
+			std::copy(data->data() + pageOffset, data->data() + pageOffset + size, output + (position - static_cast<std::uint64_t>(offset)));
+			position += size;
+		}
+
+		if(position < end) {
+			/* sqlite3 requires the missing part to be zero filled */
+			std::fill(output + (position - static_cast<std::uint64_t>(offset)), output + amount, 0);
+			return SQLITE_IOERR_SHORT_READ;
+		}
+	}
+	catch(const std::bad_alloc&) {
+		return SQLITE_IOERR_NOMEM;
+	}
+
+	return SQLITE_OK;
+}
+
+int compressedWrite(sqlite3_file*, const void*, int, sqlite3_int64) {
+	return SQLITE_READONLY;
+}
+
+int compressedTruncate(sqlite3_file*, sqlite3_int64) {
+	return SQLITE_READONLY;
+}
+
+int compressedSync(sqlite3_file*, int) {
+	return SQLITE_OK;
+}
+
+int compressedFileSize(sqlite3_file* file, sqlite3_int64* size) {
+	*size = static_cast<sqlite3_int64>(getCompressedFile(file).archive->fileSize);
+	return SQLITE_OK;
+}
+
+int compressedLock(sqlite3_file* file, int lock) {
+	sqlite3_file& realFile = *getCompressedFile(file).realFile;
+	return realFile.pMethods->xLock(&realFile, lock);
+}
+
+int compressedUnlock(sqlite3_file* file, int lock) {
+	sqlite3_file& realFile = *getCompressedFile(file).realFile;
+	return realFile.pMethods->xUnlock(&realFile, lock);
+}
+
+int compressedCheckReservedLock(sqlite3_file* file, int* result) {
+	sqlite3_file& realFile = *getCompressedFile(file).realFile;
+	return realFile.pMethods->xCheckReservedLock(&realFile, result);
+}
+
+int compressedFileControl(sqlite3_file* file, int operation, void* argument) {
+	if(operation == SQLITE_FCNTL_SIZE_HINT || operation == SQLITE_FCNTL_MMAP_SIZE) {
+		return SQLITE_NOTFOUND;
+	}
+	sqlite3_file& realFile = *getCompressedFile(file).realFile;
+	return realFile.pMethods->xFileControl(&realFile, operation, argument);
+}
+
+int compressedSectorSize(sqlite3_file* file) {
+	sqlite3_file& realFile = *getCompressedFile(file).realFile;
+	return realFile.pMethods->xSectorSize(&realFile);
+}
+
+int compressedDeviceCharacteristics(sqlite3_file* file) {
+	sqlite3_file& realFile = *getCompressedFile(file).realFile;
+	return realFile.pMethods->xDeviceCharacteristics(&realFile);
+}
+
+/* version 1, i.e. no shared memory (WAL) and no memory mapping */
+const sqlite3_io_methods compressedIoMethods = {
+	1,
+	compressedClose,
+	compressedRead,
+	compressedWrite,
+	compressedTruncate,
+	compressedSync,
+	compressedFileSize,
+	compressedLock,
+	compressedUnlock,
+	compressedCheckReservedLock,
+	compressedFileControl,
+	compressedSectorSize,
+	compressedDeviceCharacteristics,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr
+};
+
+/* Returns nullptr if "realFile" is not compressed */
+Archive* openArchive(sqlite3_file& realFile, const char* name) {
+	sqlite3_int64 realSize = 0;
+	if(realFile.pMethods->xFileSize(&realFile, &realSize) != SQLITE_OK || realSize < static_cast<sqlite3_int64>(headerSize)) {
+		return nullptr;
+	}
+
+	unsigned char header[headerSize];
+	if(readReal(realFile, header, headerSize, 0) != SQLITE_OK || std::memcmp(header, magic, sizeof(magic)) != 0) {
+		return nullptr;
+	}
+
+	std::unique_ptr<Archive> archive(new Archive);
+	if(decode32(header + 4) != formatVersion) {
+		logger.warn << "Compressed database \"" << (name ? name : "") << "\" has unknown format version " << decode32(header + 4) << "\n";
+		return nullptr;
+	}
+	archive->pageSize = decode32(header + 8);
+	archive->fileSize = decode64(header + 16);
+	std::uint64_t indexOffset = decode64(header + 24);
+	if(archive->pageSize == 0) {
+		return nullptr;
+	}
+
+	std::uint64_t pages = (archive->fileSize + archive->pageSize - 1) / archive->pageSize;
+	std::vector<unsigned char> indexData(pages * indexEntrySize);
+	if(!indexData.empty() && readReal(realFile, indexData.data(), indexData.size(), indexOffset) != SQLITE_OK) {
+		return nullptr;
+	}
+
+	archive->index.resize(pages);
+	for(std::uint64_t page=0; page<pages; ++page) {
+		const unsigned char* data = indexData.data() + page * indexEntrySize;
+		archive->index[page].offset = decode64(data);
+		archive->index[page].size = decode32(data + 8);
+		archive->index[page].flags = decode32(data + 12);
+	}
+
+	sqlite3_int64 cachePages = sqlite3_uri_int64(name, "compressed_cache_pages", 64);
+	archive->cachePages = cachePages > 0 ? static_cast<std::size_t>(cachePages) : 1;
+
+	return archive.release();
+}
+
+int compressedOpen(sqlite3_vfs* vfs, const char* name, sqlite3_file* file, int flags, int* outFlags) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+
+	if((flags & SQLITE_OPEN_MAIN_DB) == 0) {
+		return baseVfs.xOpen(&baseVfs, name, file, flags, outFlags);
+	}
+
+	CompressedFile& compressedFile = getCompressedFile(file);
+	compressedFile.base.pMethods = nullptr;
+	compressedFile.archive = nullptr;
+	compressedFile.realFile = reinterpret_cast<sqlite3_file*>(&compressedFile + 1);
+
+	int rc = baseVfs.xOpen(&baseVfs, name, compressedFile.realFile, flags, outFlags);
+	if(rc != SQLITE_OK) {
+		if(compressedFile.realFile->pMethods) {
+			compressedFile.realFile->pMethods->xClose(compressedFile.realFile);
+		}
+		return rc;
+	}
+
+	try {
+		compressedFile.archive = openArchive(*compressedFile.realFile, name);
+	}
+	catch(const std::bad_alloc&) {
+		compressedFile.realFile->pMethods->xClose(compressedFile.realFile);
+		return SQLITE_NOMEM;
+	}
+
+	if(compressedFile.archive == nullptr) {
+		/* plain database, the base VFS opens it again directly */
+		compressedFile.realFile->pMethods->xClose(compressedFile.realFile);
+		return baseVfs.xOpen(&baseVfs, name, file, flags, outFlags);
+	}
+
+	compressedFile.base.pMethods = &compressedIoMethods;
+	return SQLITE_OK;
+}
+
+int compressedDelete(sqlite3_vfs* vfs, const char* name, int syncDir) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xDelete(&baseVfs, name, syncDir);
+}
+
+int compressedAccess(sqlite3_vfs* vfs, const char* name, int flags, int* result) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xAccess(&baseVfs, name, flags, result);
+}
+
+int compressedFullPathname(sqlite3_vfs* vfs, const char* name, int size, char* output) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xFullPathname(&baseVfs, name, size, output);
+}
+
+int compressedRandomness(sqlite3_vfs* vfs, int size, char* output) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xRandomness(&baseVfs, size, output);
+}
+
+int compressedSleep(sqlite3_vfs* vfs, int microseconds) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xSleep(&baseVfs, microseconds);
+}
+
+int compressedCurrentTime(sqlite3_vfs* vfs, double* time) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xCurrentTime(&baseVfs, time);
+}
+
+int compressedGetLastError(sqlite3_vfs* vfs, int size, char* message) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xGetLastError ? baseVfs.xGetLastError(&baseVfs, size, message) : 0;
+}
+
+int compressedCurrentTimeInt64(sqlite3_vfs* vfs, sqlite3_int64* time) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xCurrentTimeInt64(&baseVfs, time);
+}
+
+void throwOnError(int rc, const std::string& message, sqlite3* connectionHandle = nullptr) {
+	if(rc != SQLITE_OK) {
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, connectionHandle));
+	}
+}
+
+struct FileCloser {
+	void operator()(std::FILE* file) const {
+		std::fclose(file);
+	}
+};
+#endif
+}
+
+bool CompressedVfs::isAvailable() noexcept {
+#ifdef SQLITE4ESL_WITH_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef SQLITE4ESL_WITH_ZLIB
+std::string CompressedVfs::install(const std::string& baseVfsName) {
+	sqlite3_vfs* baseVfs = sqlite3_vfs_find(baseVfsName.empty() ? nullptr : baseVfsName.c_str());
+	if(baseVfs == nullptr) {
+        throw esl::system::Stacktrace::add(std::runtime_error("VFS \"" + baseVfsName + "\" is not registered"));
+	}
+
+	std::lock_guard<std::mutex> lock(vfsMutex);
+
+	std::unique_ptr<Vfs>& compressedVfs = vfsByBase[baseVfs->zName];
+	if(compressedVfs) {
+		return compressedVfs->name;
+	}
+
+	compressedVfs.reset(new Vfs);
+	compressedVfs->baseVfs = baseVfs;
+	compressedVfs->name = std::string("sqlite4esl-compressed-") + baseVfs->zName;
+
+	sqlite3_vfs& vfs = compressedVfs->vfs;
+	vfs = sqlite3_vfs();
+	vfs.iVersion = 2;
+	/* plain files are opened by the base VFS into the same memory */
+	vfs.szOsFile = static_cast<int>(sizeof(CompressedFile)) + baseVfs->szOsFile;
+	vfs.mxPathname = baseVfs->mxPathname;
+	vfs.zName = compressedVfs->name.c_str();
+	vfs.pAppData = compressedVfs.get();
+	vfs.xOpen = compressedOpen;
+	vfs.xDelete = compressedDelete;
+	vfs.xAccess = compressedAccess;
+	vfs.xFullPathname = compressedFullPathname;
+	vfs.xRandomness = compressedRandomness;
+	vfs.xSleep = compressedSleep;
+	vfs.xCurrentTime = compressedCurrentTime;
+	vfs.xGetLastError = compressedGetLastError;
+	vfs.xCurrentTimeInt64 = baseVfs->iVersion >= 2 && baseVfs->xCurrentTimeInt64 ? compressedCurrentTimeInt64 : nullptr;
+
+	int rc = sqlite3_vfs_register(&vfs, 0);
+	if(rc != SQLITE_OK) {
+		std::string name = compressedVfs->name;
+		vfsByBase.erase(baseVfs->zName);
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot register VFS \"" + name + "\": " + sqlite3_errstr(rc)));
+	}
+
+	return compressedVfs->name;
+}
+#else
+std::string CompressedVfs::install(const std::string&) {
+    throw esl::system::Stacktrace::add(std::runtime_error("Compressed databases are not available, because sqlite4esl is built without zlib"));
+}
+#endif
+
+#ifdef SQLITE4ESL_WITH_ZLIB
+CompressedVfs::Statistics CompressedVfs::compress(const std::string& source, const std::string& target, int level) {
+	Statistics statistics;
+	std::string plainFile = target + ".plain";
+	std::remove(plainFile.c_str());
+
+	{
+		sqlite3* connectionHandle = nullptr;
+		int rc = sqlite3_open_v2(source.c_str(), &connectionHandle, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr);
+		std::unique_ptr<sqlite3, int(*)(sqlite3*)> connectionHandlePtr(connectionHandle, sqlite3_close_v2);
+		throwOnError(rc, "Can't open database \"" + source + "\"", connectionHandle);
+
+		sqlite3_stmt* stmt = nullptr;
+		rc = sqlite3_prepare_v2(connectionHandle, "VACUUM INTO ?", -1, &stmt, nullptr);
+		std::unique_ptr<sqlite3_stmt, int(*)(sqlite3_stmt*)> stmtPtr(stmt, sqlite3_finalize);
+		throwOnError(rc, "Can't prepare VACUUM INTO", connectionHandle);
+
+		sqlite3_bind_text(stmt, 1, plainFile.c_str(), -1, SQLITE_TRANSIENT);
+		rc = sqlite3_step(stmt);
+		throwOnError(rc == SQLITE_DONE ? SQLITE_OK : rc, "Can't copy database \"" + source + "\"", connectionHandle);
+	}
+
+	try {
+		std::unique_ptr<std::FILE, FileCloser> input(std::fopen(plainFile.c_str(), "rb"));
+		std::unique_ptr<std::FILE, FileCloser> output(std::fopen(target.c_str(), "wb"));
+		if(!input || !output) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Cannot open \"" + plainFile + "\" or \"" + target + "\""));
+		}
+
+		unsigned char databaseHeader[100];
+		if(std::fread(databaseHeader, 1, sizeof(databaseHeader), input.get()) != sizeof(databaseHeader)) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Database \"" + source + "\" is too small"));
+		}
+		std::uint32_t pageSize = (static_cast<std::uint32_t>(databaseHeader[16]) << 8) | databaseHeader[17];
+		if(pageSize == 1) {
+			pageSize = 65536;
+		}
+		std::rewind(input.get());
+
+		unsigned char header[headerSize] = {};
+		std::fwrite(header, 1, headerSize, output.get());
+
+		std::vector<IndexEntry> index;
+		std::vector<unsigned char> page(pageSize);
+		std::vector<unsigned char> compressed(compressBound(pageSize));
+		std::uint64_t offset = headerSize;
+		std::size_t size;
+		while((size = std::fread(page.data(), 1, pageSize, input.get())) > 0) {
+			if(index.empty() && size > 19) {
+				/* read and write version 1, i.e. journal mode DELETE instead of WAL */
+				page[18] = 1;
+				page[19] = 1;
+			}
+
+			uLongf compressedSize = compressed.size();
+			if(compress2(compressed.data(), &compressedSize, page.data(), size, level) != Z_OK) {
+		        throw esl::system::Stacktrace::add(std::runtime_error("Cannot compress page " + std::to_string(index.size() + 1)));
+			}
+
+			IndexEntry indexEntry;
+			indexEntry.offset = offset;
+			if(compressedSize < size) {
+				indexEntry.size = static_cast<std::uint32_t>(compressedSize);
+				indexEntry.flags = 0;
+				std::fwrite(compressed.data(), 1, compressedSize, output.get());
+			}
+			else {
+				indexEntry.size = static_cast<std::uint32_t>(size);
+				indexEntry.flags = rawPage;
+				std::fwrite(page.data(), 1, size, output.get());
+			}
+			index.push_back(indexEntry);
+
+			offset += indexEntry.size;
+			statistics.bytes += size;
+		}
+
+		unsigned char indexData[indexEntrySize];
+		for(const auto& indexEntry : index) {
+			encode64(indexData, indexEntry.offset);
+			encode32(indexData + 8, indexEntry.size);
+			encode32(indexData + 12, indexEntry.flags);
+			std::fwrite(indexData, 1, indexEntrySize, output.get());
+		}
+
+		std::memcpy(header, magic, sizeof(magic));
+		encode32(header + 4, formatVersion);
+		encode32(header + 8, pageSize);
+		encode64(header + 16, statistics.bytes);
+		encode64(header + 24, offset);
+		std::rewind(output.get());
+		std::fwrite(header, 1, headerSize, output.get());
+
+		if(std::ferror(output.get()) || std::fflush(output.get()) != 0) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Cannot write \"" + target + "\""));
+		}
+
+		statistics.pages = index.size();
+		statistics.compressedBytes = offset + index.size() * indexEntrySize;
+	}
+	catch(...) {
+		std::remove(plainFile.c_str());
+		std::remove(target.c_str());
+		throw;
+	}
+	std::remove(plainFile.c_str());
+
+	logger.info << "Compressed database \"" << source << "\" from " << statistics.bytes << " to " << statistics.compressedBytes << " bytes\n";
+	return statistics;
+}
+#else
+CompressedVfs::Statistics CompressedVfs::compress(const std::string&, const std::string&, int) {
+    throw esl::system::Stacktrace::add(std::runtime_error("Compressed databases are not available, because sqlite4esl is built without zlib"));
+}
+#endif
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,60 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_COMPRESSEDVFS_H_
+#define SQLITE4ESL_DATABASE_COMPRESSEDVFS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* VFS for read only archive databases whose pages are stored zlib compressed.
+ * A compressed file starts with a header ("S4EZ", version, page size, size of the
+ * database), followed by the compressed pages and an index with offset and size of
+ * every page. Decompressed pages are kept in a LRU cache per open file, its size is
+ * given by URI parameter "compressed_cache_pages" (default 64). Files without the header
+ * and all other files (journals, temporary files) are passed to the base VFS, so
+ * compressed and plain databases can be opened through the same VFS. Writing to a
+ * compressed database fails with SQLITE_READONLY. Requires sqlite4esl built with zlib. */
+class CompressedVfs {
+public:
+	struct Statistics {
+		std::uint64_t pages = 0;
+		std::uint64_t bytes = 0;
+		std::uint64_t compressedBytes = 0;
+	};
+
+	static bool isAvailable() noexcept;
+
+	/* Registers the VFS on top of "baseVfs" (the default VFS if empty) and returns its name */
+	static std::string install(const std::string& baseVfs);
+
+	/* Writes a compressed copy of database "source" to "target". The copy is made with
+	 * VACUUM INTO, so it is consistent while "source" is in use, and uses journal mode
+	 * DELETE. "level" is the zlib compression level from 1 (fast) to 9 (small). */
+	static Statistics compress(const std::string& source, const std::string& target, int level = 6);
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_COMPRESSEDVFS_H_ */
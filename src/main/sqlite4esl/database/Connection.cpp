@@ -18,11 +18,16 @@
 
 #include <sqlite4esl/database/Connection.h>
 #include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/ExecutionStatistics.h>
+#include <sqlite4esl/database/PrefetchResultSetBinding.h>
 #include <sqlite4esl/database/PreparedStatementBinding.h>
 #include <sqlite4esl/database/PreparedBulkStatementBinding.h>
+#include <sqlite4esl/database/UnlockNotification.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
 
 #include <esl/Logger.h>
 
+#include <esl/database/Column.h>
 #include <esl/database/Diagnostic.h>
 #include <esl/database/exception/SqlError.h>
 #include <esl/database/PreparedStatement.h>
@@ -40,14 +45,19 @@ esl::Logger logger("sqlite4esl::database::Connection");
 std::set<std::string> implementations{{"SQLite"}};
 }
 
-Connection::Connection(ConnectionFactory& aConnectionFactory, const sqlite3& aConnectionHandle)
+Connection::Connection(ConnectionFactory& aConnectionFactory, const sqlite3& aConnectionHandle, HandleContext* aHandleContext)
 : connectionFactory(aConnectionFactory),
-  connectionHandle(aConnectionHandle)
+  connectionHandle(aConnectionHandle),
+  handleContext(aHandleContext)
 {
+	if(handleContext && handleContext->executionControl) {
+		executionLimits = std::make_shared<ExecutionControl::Limits>();
+		executionLimits->timeout = std::chrono::milliseconds(connectionFactory.getSettings().statementTimeoutMS);
+	}
 }
 
 Connection::~Connection() {
-	connectionFactory.doUnlock();
+	connectionFactory.releaseConnectionHandle(connectionHandle);
 }
 
 const sqlite3& Connection::getConnectionHandle() const {
@@ -59,6 +69,10 @@ const sqlite3& Connection::getConnectionHandle() const {
 	return connectionHandle;
 }
 
+MemoryStatistics Connection::getMemoryStatistics(bool reset) const {
+	return MemoryStatistics::get(const_cast<sqlite3&>(connectionHandle), reset);
+}
+
 esl::database::PreparedStatement Connection::prepare(const std::string& sql) const {
 	return esl::database::PreparedStatement(std::unique_ptr<esl::database::PreparedStatement::Binding>(new PreparedStatementBinding(*this, sql)));
 }
@@ -68,20 +82,137 @@ esl::database::PreparedBulkStatement Connection::prepareBulk(const std::string&
 }
 
 StatementHandle Connection::prepareSQLite(const std::string& sql) const {
-	sqlite3_stmt* stmt = nullptr;
+	sqlite3_stmt* stmt = (handleContext && handleContext->hotStatements) ? handleContext->hotStatements->acquire(sql) : nullptr;
+	if(stmt) {
+		StatementHandle statementHandle(*stmt, *handleContext->hotStatements);
+		statementHandle.setHandleContext(handleContext);
+		statementHandle.setExecutionLimits(executionLimits);
+
+		QueryPlanRecorder* queryPlanRecorder = connectionFactory.getQueryPlanRecorder();
+		if(queryPlanRecorder) {
+			statementHandle.setQueryPlan(queryPlanRecorder->get(const_cast<sqlite3&>(connectionHandle), sql));
+		}
+
+		return statementHandle;
+	}
+
 	int rc = sqlite3_prepare_v2(const_cast<sqlite3*>(&connectionHandle), sql.c_str(), sql.length() + 1, &stmt, nullptr);
+	while(rc == SQLITE_LOCKED_SHAREDCACHE) {
+		/* schema of a shared cache database is locked by another handle */
+		rc = UnlockNotification::wait(const_cast<sqlite3&>(connectionHandle));
+		if(rc != SQLITE_OK) {
+			break;
+		}
+		rc = sqlite3_prepare_v2(const_cast<sqlite3*>(&connectionHandle), sql.c_str(), sql.length() + 1, &stmt, nullptr);
+	}
 	if(rc != SQLITE_OK) {
-        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Can't prepare SQL statement \"" + sql + "\": ") + sqlite3_errstr(rc)));
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Can't prepare SQL statement \"" + sql + "\"", rc, const_cast<sqlite3*>(&connectionHandle)));
 	}
+	ExecutionStatistics::add(ExecutionStatistics::prepares);
 
-	return StatementHandle(*stmt);
+	StatementHandle statementHandle(*stmt);
+	statementHandle.setHandleContext(handleContext);
+	statementHandle.setExecutionLimits(executionLimits);
+
+	QueryPlanRecorder* queryPlanRecorder = connectionFactory.getQueryPlanRecorder();
+	if(queryPlanRecorder) {
+		statementHandle.setQueryPlan(queryPlanRecorder->get(const_cast<sqlite3&>(connectionHandle), sql));
+	}
+
+	return statementHandle;
+}
+
+esl::database::ResultSet Connection::executePrefetching(const std::string& sql, const std::vector<esl::database::Field>& parameters, std::size_t slots) const {
+	StatementHandle statementHandle = prepareSQLite(sql);
+	statementHandle.bind(parameters);
+
+	std::vector<esl::database::Column> resultColumns;
+	for(std::size_t i=0; i<statementHandle.columnCount(); ++i) {
+		resultColumns.emplace_back(statementHandle.columnName(i), esl::database::Column::Type::sqlUnknown, true, 0, 0, 0, 0, 0);
+	}
+
+	if(!statementHandle.step()) {
+		statementHandle.reset();
+		return esl::database::ResultSet();
+	}
+
+	return esl::database::ResultSet(std::unique_ptr<esl::database::ResultSet::Binding>(new PrefetchResultSetBinding(std::move(statementHandle), resultColumns, slots)));
+}
+
+void Connection::addInstaller(std::function<void(sqlite3&)> installer) const {
+	connectionFactory.addInstaller(std::move(installer));
+	connectionFactory.install(connectionHandle);
+}
+
+void Connection::addFunction(Function function) const {
+	connectionFactory.addFunction(std::move(function));
+	connectionFactory.install(connectionHandle);
+}
+
+ConnectionFactory& Connection::getConnectionFactory() const noexcept {
+	return connectionFactory;
+}
+
+HandleContext* Connection::getHandleContext() const noexcept {
+	return handleContext;
+}
+
+void Connection::addBulkStatementBinding(PreparedBulkStatementBinding& bulkStatementBinding) const {
+	bulkStatementBindings.insert(&bulkStatementBinding);
+}
+
+void Connection::removeBulkStatementBinding(PreparedBulkStatementBinding& bulkStatementBinding) const {
+	bulkStatementBindings.erase(&bulkStatementBinding);
+}
+
+void Connection::flushBulkStatementBindings() const {
+	for(auto bulkStatementBinding : bulkStatementBindings) {
+		bulkStatementBinding->flush();
+	}
+}
+
+void Connection::setBulkStatementError(std::string error) const {
+	if(bulkStatementError.empty()) {
+		bulkStatementError = std::move(error);
+	}
+}
+
+void Connection::setStatementTimeout(std::chrono::milliseconds timeout) const {
+	if(!executionLimits) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Statement timeout is not available for this connection"));
+	}
+	executionLimits->timeout = timeout;
+}
+
+void Connection::setCancellationToken(CancellationToken cancellationToken) const {
+	if(!executionLimits) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Cancellation is not available for this connection"));
+	}
+	executionLimits->cancellationToken = std::move(cancellationToken);
+}
+
+void Connection::interrupt() const noexcept {
+	/* sqlite3_interrupt() would interrupt the statements of every connection sharing the handle */
+	if(executionLimits) {
+		executionLimits->interrupted.store(true);
+	}
 }
 
 void Connection::commit() const {
+	flushBulkStatementBindings();
+	if(!bulkStatementError.empty()) {
+		std::string error;
+		error.swap(bulkStatementError);
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot commit, because buffered rows of a bulk statement have not been written: " + error));
+	}
 	prepare("COMMIT;").execute();
 }
 
 void Connection::rollback() const {
+	for(auto bulkStatementBinding : bulkStatementBindings) {
+		bulkStatementBinding->discard();
+	}
+	bulkStatementError.clear();
 	prepare("ROLLBACK;").execute();
 }
 
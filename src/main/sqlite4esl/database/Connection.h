@@ -19,17 +19,27 @@
 #ifndef SQLITE4ESL_DATABASE_CONNECTION_H_
 #define SQLITE4ESL_DATABASE_CONNECTION_H_
 
+#include <sqlite4esl/database/CancellationToken.h>
+#include <sqlite4esl/database/Function.h>
+#include <sqlite4esl/database/HandleContext.h>
+#include <sqlite4esl/database/MemoryStatistics.h>
 #include <sqlite4esl/database/StatementHandle.h>
+#include <sqlite4esl/database/VirtualTable.h>
 
 #include <esl/database/Connection.h>
+#include <esl/database/Field.h>
 #include <esl/database/PreparedStatement.h>
 #include <esl/database/PreparedBulkStatement.h>
+#include <esl/database/ResultSet.h>
 
 #include <sqlite3.h>
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace sqlite4esl {
@@ -37,19 +47,73 @@ inline namespace v1_6 {
 namespace database {
 
 class ConnectionFactory;
+class PreparedBulkStatementBinding;
 
 class Connection : public esl::database::Connection {
 public:
-	Connection(ConnectionFactory& connectionFactory, const sqlite3& connectionHandle);
+	Connection(ConnectionFactory& connectionFactory, const sqlite3& connectionHandle, HandleContext* handleContext = nullptr);
 	~Connection();
 
 	const sqlite3& getConnectionHandle() const;
+	ConnectionFactory& getConnectionFactory() const noexcept;
+	/* Returns nullptr for handles that are not pooled */
+	HandleContext* getHandleContext() const noexcept;
 
 	esl::database::PreparedStatement prepare(const std::string& sql) const override;
 	esl::database::PreparedBulkStatement prepareBulk(const std::string& sql) const override;
 	StatementHandle prepareSQLite(const std::string& sql) const;
+	/* Executes "sql" and reads up to "slots" rows ahead on a producer thread, see
+	 * PrefetchResultSetBinding. The connection must not be used until the result set is
+	 * read completely or destroyed. */
+	esl::database::ResultSet executePrefetching(const std::string& sql, const std::vector<esl::database::Field>& parameters, std::size_t slots = 1024) const;
 	//esl::database::ResultSet getTable(const std::string& tableName);
 
+	/* Installs on this connection and on every handle of the connection factory */
+	void addInstaller(std::function<void(sqlite3&)> installer) const;
+	void addFunction(Function function) const;
+
+	template<typename Container>
+	void addVirtualTable(VirtualTable<Container> virtualTable) const {
+		std::shared_ptr<VirtualTable<Container>> virtualTablePtr(new VirtualTable<Container>(std::move(virtualTable)));
+		addInstaller([virtualTablePtr](sqlite3& connectionHandle) {
+			virtualTablePtr->install(connectionHandle);
+		});
+	}
+
+	template<typename Signature, typename Callable>
+	void registerFunction(const std::string& name, Callable callable, bool deterministic = false) const {
+		addFunction(Function::scalar<Signature>(name, std::move(callable), deterministic));
+	}
+
+	template<typename State, typename Signature, typename Step, typename Final>
+	void registerAggregate(const std::string& name, Step step, Final final, bool deterministic = false) const {
+		addFunction(Function::aggregate<State, Signature>(name, std::move(step), std::move(final), deterministic));
+	}
+
+	template<typename State, typename Signature, typename Step, typename Inverse, typename Current, typename Final>
+	void registerWindowFunction(const std::string& name, Step step, Inverse inverse, Current value, Final final, bool deterministic = false) const {
+		addFunction(Function::window<State, Signature>(name, std::move(step), std::move(inverse), std::move(value), std::move(final), deterministic));
+	}
+
+	MemoryStatistics getMemoryStatistics(bool reset = false) const;
+
+	/* Statements of this connection that run longer than "timeout" fail with
+	 * SQLITE_INTERRUPT, 0 disables the deadline. Default is the setting "statementTimeout". */
+	void setStatementTimeout(std::chrono::milliseconds timeout) const;
+	/* Statements of this connection fail with SQLITE_INTERRUPT once the token is cancelled */
+	void setCancellationToken(CancellationToken cancellationToken) const;
+	/* Interrupts the running execution of this connection, may be called from any thread.
+	 * Statements of other connections sharing the handle are not affected. */
+	void interrupt() const noexcept;
+
+	/* Bulk statements that buffer rows are flushed on commit and discarded on rollback */
+	void addBulkStatementBinding(PreparedBulkStatementBinding& bulkStatementBinding) const;
+	void removeBulkStatementBinding(PreparedBulkStatementBinding& bulkStatementBinding) const;
+	void flushBulkStatementBindings() const;
+	/* Called by a destroyed bulk statement whose buffered rows could not be written,
+	 * the next commit fails with this error */
+	void setBulkStatementError(std::string error) const;
+
 	void commit() const override;
 	void rollback() const override;
 	bool isClosed() const override;
@@ -62,6 +126,12 @@ private:
 	ConnectionFactory& connectionFactory;
 	const sqlite3& connectionHandle;
 	//sqlite3* connectionHandle = nullptr;
+	HandleContext* handleContext;
+	/* nullptr if the handle has no execution control */
+	std::shared_ptr<ExecutionControl::Limits> executionLimits;
+
+	mutable std::set<PreparedBulkStatementBinding*> bulkStatementBindings;
+	mutable std::string bulkStatementError;
 };
 
 } /* namespace database */
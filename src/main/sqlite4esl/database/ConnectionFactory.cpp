@@ -17,7 +17,9 @@
  */
 
 #include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/CompressedVfs.h>
 #include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
 
 #include <esl/database/exception/SqlError.h>
 #include <esl/Logger.h>
@@ -25,6 +27,8 @@
 #include <esl/system/Stacktrace.h>
 
 #include <chrono>
+#include <cstdlib>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 
@@ -34,110 +38,605 @@ namespace database {
 
 namespace {
 esl::Logger logger("sqlite4esl::database::ConnectionFactory");
+
+std::once_flag pageCacheConfigured;
+
+std::string toImmutableUri(const std::string& uri) {
+	if(uri.compare(0, 5, "file:") == 0) {
+		std::string::size_type fragment = uri.find('#');
+		std::string result = uri.substr(0, fragment);
+		result += (result.find('?') == std::string::npos) ? "?immutable=1" : "&immutable=1";
+		if(fragment != std::string::npos) {
+			result += uri.substr(fragment);
+		}
+		return result;
+	}
+
+	/* plain filename, characters with special meaning in a URI have to be escaped */
+	std::string result = "file:";
+	for(char c : uri) {
+		switch(c) {
+		case '%':
+			result += "%25";
+			break;
+		case '?':
+			result += "%3f";
+			break;
+		case '#':
+			result += "%23";
+			break;
+		default:
+			result += c;
+			break;
+		}
+	}
+	return result + "?immutable=1";
 }
 
-ConnectionFactory::ConnectionFactory(esl::database::SQLiteConnectionFactory::Settings aSettings)
-: settings(std::move(aSettings))
-{ }
+int queryInt64(sqlite3& connectionHandle, const char* sql, sqlite3_int64& value) {
+	sqlite3_stmt* statement = nullptr;
+	int rc = sqlite3_prepare_v2(&connectionHandle, sql, -1, &statement, nullptr);
+	if(rc != SQLITE_OK) {
+		return rc;
+	}
 
-ConnectionFactory::~ConnectionFactory() {
-	if(connectionHandle) {
-		std::lock_guard<std::timed_mutex> lock(timedMutex);
+	rc = sqlite3_step(statement);
+	if(rc == SQLITE_ROW) {
+		value = sqlite3_column_int64(statement, 0);
+		rc = SQLITE_OK;
+	}
+	else if(rc == SQLITE_DONE) {
+		/* e.g. PRAGMA mmap_size returns no row if mmap is not supported */
+		value = 0;
+		rc = SQLITE_OK;
+	}
+
+	sqlite3_finalize(statement);
+	return rc;
+}
 
-		esl::monitoring::Streams::Location location;
-		location.file = __FILE__;
-		location.function = __func__;
+void configurePageCache(int slotSize, int slots) {
+	if(slotSize <= 0 || slots <= 0) {
+		return;
+	}
 
-		try {
-			int rc = sqlite3_close(connectionHandle);
-			if(rc != SQLITE_OK) {
-				logger.warn << "sqlite3_close(...) returned " << rc << ": " << sqlite3_errstr(rc) << "\n";
-				logger.warn << "Trying to close connection with sqlite3_close_v2(...) ...\n";
-				rc = sqlite3_close_v2(connectionHandle);
-				if(rc != SQLITE_OK) {
-			        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Cannot close database connection: ") + sqlite3_errstr(rc)));
-				}
-			}
+	std::call_once(pageCacheConfigured, [slotSize, slots]() {
+		/* the slab is used by sqlite3 until the process terminates, so it is never freed */
+		void* slab = std::malloc(static_cast<std::size_t>(slotSize) * static_cast<std::size_t>(slots));
+		if(slab == nullptr) {
+			logger.warn << "Cannot allocate page cache slab of " << slots << " slots with " << slotSize << " bytes\n";
+			return;
 		}
-		catch (const esl::database::exception::SqlError& e) {
-			ESL__LOGGER_WARN_THIS("esl::database::exception::SqlError exception occured\n");
-			ESL__LOGGER_WARN_THIS(e.what(), "\n");
-			location.line = __LINE__;
-			e.getDiagnostics().dump(logger.warn, location);
 
-			const esl::system::Stacktrace* stacktrace = esl::system::Stacktrace::get(e);
-			if(stacktrace) {
-				location.line = __LINE__;
-				stacktrace->dump(logger.warn, location);
-			}
-			else {
-				ESL__LOGGER_WARN_THIS("no stacktrace\n");
-			}
+		int rc = sqlite3_config(SQLITE_CONFIG_PAGECACHE, slab, slotSize, slots);
+		if(rc != SQLITE_OK) {
+			/* SQLITE_MISUSE if sqlite3 has been initialized already */
+			logger.warn << "sqlite3_config(SQLITE_CONFIG_PAGECACHE, ...) returned " << rc << ": " << sqlite3_errstr(rc) << "\n";
+			logger.warn << "Page cache slab is not used, because sqlite3 has been initialized before.\n";
+			std::free(slab);
 		}
-		catch(const std::exception& e) {
-			ESL__LOGGER_WARN_THIS("std::exception exception occured\n");
-			ESL__LOGGER_WARN_THIS(e.what(), "\n");
+	});
+}
 
-			const esl::system::Stacktrace* stacktrace = esl::system::Stacktrace::get(e);
-			if(stacktrace) {
-				location.line = __LINE__;
-				stacktrace->dump(logger.warn, location);
-			}
-			else {
-				ESL__LOGGER_WARN_THIS("no stacktrace\n");
-			}
-		}
-		catch (...) {
-			ESL__LOGGER_ERROR_THIS("unkown exception occured\n");
+/* I/O statistics count the bytes read from disk, i.e. compressed bytes */
+std::string installVfs(const esl::database::SQLiteConnectionFactory::Settings& settings) {
+	std::string vfs = settings.vfs;
+	if(settings.ioStatistics) {
+		vfs = InstrumentedVfs::install(vfs);
+	}
+	if(settings.compression) {
+		vfs = CompressedVfs::install(vfs);
+	}
+	return vfs;
+}
+}
+
+ConnectionFactory::ConnectionFactory(esl::database::SQLiteConnectionFactory::Settings aSettings)
+: settings(std::move(aSettings)),
+  openUri(settings.immutable ? toImmutableUri(settings.uri) : settings.uri),
+  vfs(installVfs(settings))
+{
+	configurePageCache(settings.pageCacheSlotSize, settings.pageCacheSlots);
+
+	if(settings.queryPlanCapture) {
+		queryPlanRecorder.reset(new QueryPlanRecorder(settings.queryPlanFullScanThreshold, settings.queryPlanAutoIndexThreshold, static_cast<std::size_t>(settings.queryPlanMaxStatements)));
+	}
+
+	if(settings.resultCacheSize > 0) {
+		resultCache.reset(new ResultCache(static_cast<std::size_t>(settings.resultCacheSize)));
+		ResultCache* resultCachePtr = resultCache.get();
+		changeCapture.subscribeTables([resultCachePtr](const std::vector<std::string>& tables) {
+			resultCachePtr->invalidate(tables);
+		});
+	}
+}
+
+ConnectionFactory::~ConnectionFactory() {
+	if(maintenanceScheduler) {
+		/* the maintenance thread locks connectionHandlesMutex to borrow idle handles */
+		maintenanceScheduler->stop();
+	}
+
+	std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+
+	if(maintenanceScheduler) {
+		for(auto& handleContext : handleContexts) {
+			maintenanceScheduler->optimize(*const_cast<sqlite3*>(handleContext.first), *handleContext.second->executionControl);
 		}
 	}
+
+	/* pinned statements have to be finalized before their handles are closed */
+	handleContexts.clear();
+	for(auto connectionHandle : connectionHandles) {
+		closeConnectionHandle(*connectionHandle);
+	}
+
+	checkpointScheduler.reset();
+	if(checkpointConnectionHandle) {
+		closeConnectionHandle(*checkpointConnectionHandle);
+	}
+
+	maintenanceScheduler.reset();
+	if(maintenanceConnectionHandle) {
+		closeConnectionHandle(*maintenanceConnectionHandle);
+	}
 }
 
 const sqlite3& ConnectionFactory::getConnectionHandle() const {
-	if(connectionHandle == nullptr) {
+	if(connectionHandles.empty()) {
         throw esl::system::Stacktrace::add(std::runtime_error("Calling ConnectionFactory::getConnectionHandle() but db is still not opened"));
 	}
 
-	return *connectionHandle;
+	return *connectionHandles.front();
+}
+
+const esl::database::SQLiteConnectionFactory::Settings& ConnectionFactory::getSettings() const noexcept {
+	return settings;
 }
 
 std::unique_ptr<esl::database::Connection> ConnectionFactory::createConnection() {
+	std::unique_lock<std::mutex> lock(connectionHandlesMutex);
+
+	if(settings.checkpointIntervalMS > 0 && !checkpointScheduler) {
+		/* scheduler has to exist before pooled handles are opened to install its WAL hook */
+		if(checkpointConnectionHandle == nullptr) {
+			checkpointConnectionHandle = openConnectionHandle();
+		}
+		checkpointScheduler.reset(new CheckpointScheduler(*checkpointConnectionHandle,
+				std::chrono::milliseconds(settings.checkpointIntervalMS),
+				static_cast<std::uint64_t>(settings.checkpointRestartPages),
+				static_cast<std::uint64_t>(settings.checkpointTruncatePages),
+				std::chrono::milliseconds(settings.timeoutMS)));
+	}
+
+	if(settings.maintenanceIntervalMS > 0 && !maintenanceScheduler) {
+		if(maintenanceConnectionHandle == nullptr) {
+			maintenanceConnectionHandle = openConnectionHandle();
+		}
+		maintenanceScheduler.reset(new MaintenanceScheduler(*maintenanceConnectionHandle,
+				[this](const std::function<void(sqlite3&, ExecutionControl&)>& function) {
+					return withIdleConnectionHandle(function);
+				},
+				std::chrono::milliseconds(settings.maintenanceIntervalMS),
+				std::chrono::milliseconds(settings.maintenanceIdleDelayMS),
+				std::chrono::milliseconds(settings.maintenanceBudgetMS),
+				settings.analysisLimit,
+				settings.incrementalVacuumPages,
+				settings.progressInstructions));
+	}
+
+	if(isConnectionHandleShared()) {
+		if(connectionHandles.empty()) {
+			connectionHandles.reserve(1);
+			connectionHandles.push_back(openPooledConnectionHandle());
+		}
+		installPending(*connectionHandles.front());
+		++handleContexts[connectionHandles.front()]->connections;
+		if(maintenanceScheduler) {
+			maintenanceScheduler->acquired();
+		}
+		return std::unique_ptr<esl::database::Connection>(new Connection(*this, *connectionHandles.front(), handleContexts[connectionHandles.front()].get()));
+	}
+
+	if(idleConnectionHandles.empty() && connectionHandles.size() < static_cast<std::size_t>(settings.maxConnections)) {
+		connectionHandles.reserve(connectionHandles.size() + 1);
+		idleConnectionHandles.reserve(connectionHandles.size() + 1);
+
+		sqlite3* connectionHandle = openPooledConnectionHandle();
+		connectionHandles.push_back(connectionHandle);
+		idleConnectionHandles.push_back(connectionHandle);
+	}
+
+	if(connectionHandlesCondition.wait_for(lock, std::chrono::milliseconds(settings.timeoutMS), [this] { return !idleConnectionHandles.empty(); }) == false) {
+		// should we throw an exception?
+		return nullptr;
+	}
+
+	sqlite3* connectionHandle = idleConnectionHandles.back();
+	installPending(*connectionHandle);
+	idleConnectionHandles.pop_back();
+	++handleContexts[connectionHandle]->connections;
+	if(maintenanceScheduler) {
+		maintenanceScheduler->acquired();
+	}
+
+	return std::unique_ptr<esl::database::Connection>(new Connection(*this, *connectionHandle, handleContexts[connectionHandle].get()));
+}
+
+void ConnectionFactory::releaseConnectionHandle(const sqlite3& connectionHandle) {
+	if(maintenanceScheduler) {
+		maintenanceScheduler->released();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+
+		/* getMemoryStatistics() must not read a handle while it is in use. The last connection
+		 * of the handle reads it here, no other thread can acquire it while the mutex is held. */
+		auto handleContext = handleContexts.find(&connectionHandle);
+		if(handleContext != handleContexts.end() && --handleContext->second->connections == 0) {
+			handleContext->second->memoryStatistics = MemoryStatistics::get(const_cast<sqlite3&>(connectionHandle), handleContext->second->memoryStatisticsReset);
+			handleContext->second->memoryStatisticsReset = false;
+		}
+
+		if(isConnectionHandleShared()) {
+			return;
+		}
+		idleConnectionHandles.push_back(const_cast<sqlite3*>(&connectionHandle));
+	}
+	connectionHandlesCondition.notify_one();
+}
+
+void ConnectionFactory::addInstaller(std::function<void(sqlite3&)> installer) {
+	std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+	installers.push_back(std::move(installer));
+}
+
+void ConnectionFactory::addFunction(Function function) {
+	std::shared_ptr<Function> functionPtr(new Function(std::move(function)));
+	addInstaller([functionPtr](sqlite3& connectionHandle) {
+		functionPtr->install(connectionHandle);
+	});
+}
+
+void ConnectionFactory::install(const sqlite3& connectionHandle) {
+	std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+	installPending(const_cast<sqlite3&>(connectionHandle));
+}
+
+void ConnectionFactory::addHotStatement(const std::string& sql) {
+	addInstaller([this, sql](sqlite3& connectionHandle) {
+		/* installers run with connectionHandlesMutex locked */
+		auto iter = handleContexts.find(&connectionHandle);
+		if(iter != handleContexts.end()) {
+			iter->second->hotStatements->add(sql);
+		}
+	});
+}
+
+void ConnectionFactory::installPending(sqlite3& connectionHandle) {
+	std::size_t& count = installedCount[&connectionHandle];
+	for(; count < installers.size(); ++count) {
+		installers[count](connectionHandle);
+	}
+}
+
+QueryPlanRecorder* ConnectionFactory::getQueryPlanRecorder() const noexcept {
+	return queryPlanRecorder.get();
+}
+
+CheckpointScheduler::Statistics ConnectionFactory::getCheckpointStatistics() const {
+	std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+	if(!checkpointScheduler) {
+		return CheckpointScheduler::Statistics();
+	}
+	return checkpointScheduler->getStatistics();
+}
+
+MaintenanceScheduler::Statistics ConnectionFactory::getMaintenanceStatistics() const {
+	std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+	if(!maintenanceScheduler) {
+		return MaintenanceScheduler::Statistics();
+	}
+	return maintenanceScheduler->getStatistics();
+}
+
+std::size_t ConnectionFactory::subscribeChanges(ChangeCapture::Subscriber subscriber) {
+	if(!settings.changeCapture) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Change capture is disabled, set \"changeCapture\" to subscribe changes"));
+	}
+	return changeCapture.subscribe(std::move(subscriber));
+}
+
+void ConnectionFactory::unsubscribeChanges(std::size_t id) {
+	changeCapture.unsubscribe(id);
+}
+
+ResultCache* ConnectionFactory::getResultCache() const noexcept {
+	return resultCache.get();
+}
+
+MemoryStatistics ConnectionFactory::getMemoryStatistics(bool reset) const {
+	std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+
+	MemoryStatistics statistics;
+	for(auto connectionHandle : connectionHandles) {
+		auto handleContext = handleContexts.find(connectionHandle);
+		if(handleContext == handleContexts.end()) {
+			continue;
+		}
+
+		if(handleContext->second->connections == 0) {
+			handleContext->second->memoryStatistics = MemoryStatistics::get(*connectionHandle, reset);
+		}
+		else if(reset) {
+			/* handles in use (NOMUTEX) are read on release by their last connection */
+			handleContext->second->memoryStatisticsReset = true;
+		}
+		statistics += handleContext->second->memoryStatistics;
+	}
+	return statistics;
+}
+
+std::map<std::string, IoStatistics> ConnectionFactory::getIoStatistics() const {
+	if(!settings.ioStatistics) {
+		return std::map<std::string, IoStatistics>();
+	}
+
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+		if(connectionHandles.empty()) {
+			return std::map<std::string, IoStatistics>();
+		}
+
+		const char* fileName = sqlite3_db_filename(connectionHandles.front(), "main");
+		if(fileName == nullptr || *fileName == 0) {
+			/* in-memory and temporary databases */
+			return std::map<std::string, IoStatistics>();
+		}
+		path = fileName;
+	}
+
+	return InstrumentedVfs::getStatistics(path);
+}
+
+std::vector<QueryPlan::Report> ConnectionFactory::getQueryPlanReport() const {
+	if(!queryPlanRecorder) {
+		return std::vector<QueryPlan::Report>();
+	}
+	return queryPlanRecorder->getReport();
+}
+
+sqlite3* ConnectionFactory::openConnectionHandle() {
+	sqlite3* connectionHandle = nullptr;
+	int flags = SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX;
+	if(settings.readOnly) {
+		flags |= SQLITE_OPEN_READONLY;
+	}
+	else {
+		flags |= SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+	}
+	if(settings.sharedCache) {
+		flags |= SQLITE_OPEN_SHAREDCACHE;
+	}
+
+	int rc = sqlite3_open_v2(openUri.c_str(), &connectionHandle, flags, vfs.empty() ? nullptr : vfs.c_str());
+
 	if(connectionHandle == nullptr) {
-		int rc = sqlite3_open_v2(settings.uri.c_str(), &connectionHandle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX, nullptr);
+		throw esl::system::Stacktrace::add(std::runtime_error("SQLite is unable to allocate memory to open database \"" + settings.uri + "\""));
+	}
+
+	if(rc != SQLITE_OK) {
+		exception::SQLiteError error("Can't open database \"" + settings.uri + "\"", rc, connectionHandle);
+		sqlite3_close(connectionHandle);
+
+        throw esl::system::Stacktrace::add(error);
+	}
 
-		if(connectionHandle == nullptr) {
-			throw esl::system::Stacktrace::add(std::runtime_error("SQLite is unable to allocate memory to open database \"" + settings.uri + "\""));
+	if(settings.lookasideSlotSize > 0 && settings.lookasideSlots > 0) {
+		/* has to be done before the handle allocates any lookaside memory */
+		rc = sqlite3_db_config(connectionHandle, SQLITE_DBCONFIG_LOOKASIDE, nullptr, settings.lookasideSlotSize, settings.lookasideSlots);
+		if(rc != SQLITE_OK) {
+			exception::SQLiteError error("Can't configure lookaside memory", rc, connectionHandle);
+			sqlite3_close(connectionHandle);
+
+	        throw esl::system::Stacktrace::add(error);
 		}
+	}
+
+	rc = sqlite3_extended_result_codes(connectionHandle, 1);
+	if(rc != SQLITE_OK) {
+		exception::SQLiteError error("Can't enable extended result codes", rc, connectionHandle);
+		sqlite3_close(connectionHandle);
 
+        throw esl::system::Stacktrace::add(error);
+	}
+
+	if(settings.readUncommitted) {
+		/* only effective for shared cache handles: readers do not take table read locks */
+		rc = sqlite3_exec(connectionHandle, "PRAGMA read_uncommitted = 1;", nullptr, nullptr, nullptr);
 		if(rc != SQLITE_OK) {
-			std::string message = "Can't open database \"" + settings.uri + "\": " + sqlite3_errmsg(connectionHandle);
+			exception::SQLiteError error("Can't enable read uncommitted isolation", rc, connectionHandle);
 			sqlite3_close(connectionHandle);
 
-	        throw esl::system::Stacktrace::add(std::runtime_error(message));
+	        throw esl::system::Stacktrace::add(error);
 		}
+	}
 
-		rc = sqlite3_extended_result_codes(connectionHandle, 1);
+	if(settings.cacheSize != 0) {
+		std::string sql = "PRAGMA cache_size = " + std::to_string(settings.cacheSize) + ";";
+		rc = sqlite3_exec(connectionHandle, sql.c_str(), nullptr, nullptr, nullptr);
 		if(rc != SQLITE_OK) {
-			std::string message = std::string("Can't enable extended result codes: ") + sqlite3_errmsg(connectionHandle);
+			exception::SQLiteError error("Can't set cache size", rc, connectionHandle);
 			sqlite3_close(connectionHandle);
 
-	        throw esl::system::Stacktrace::add(std::runtime_error(message));
+	        throw esl::system::Stacktrace::add(error);
 		}
 	}
 
-	if(sqlite3_threadsafe() == 0) {
-		if(timedMutex.try_lock_for(std::chrono::milliseconds(settings.timeoutMS)) == false) {
-			// should we throw an exception?
-			return nullptr;
+	if(settings.mmapSize != 0) {
+		rc = setMmapSize(*connectionHandle);
+		if(rc != SQLITE_OK) {
+			exception::SQLiteError error("Can't set mmap size", rc, connectionHandle);
+			sqlite3_close(connectionHandle);
+
+	        throw esl::system::Stacktrace::add(error);
 		}
 	}
-	return std::unique_ptr<esl::database::Connection>(new Connection(*this, *connectionHandle));
+
+	if(checkpointScheduler) {
+		checkpointScheduler->install(*connectionHandle);
+	}
+
+	return connectionHandle;
 }
 
-void ConnectionFactory::doUnlock() {
-	if(sqlite3_threadsafe() == 0) {
-		timedMutex.unlock();
+int ConnectionFactory::setMmapSize(sqlite3& connectionHandle) {
+	sqlite3_int64 mmapSize = settings.mmapSize;
+
+	if(mmapSize < 0) {
+		sqlite3_int64 pageCount = 0;
+		sqlite3_int64 pageSize = 0;
+
+		int rc = queryInt64(connectionHandle, "PRAGMA page_count;", pageCount);
+		if(rc != SQLITE_OK) {
+			return rc;
+		}
+		rc = queryInt64(connectionHandle, "PRAGMA page_size;", pageSize);
+		if(rc != SQLITE_OK) {
+			return rc;
+		}
+		mmapSize = pageCount * pageSize;
+	}
+
+	std::string sql = "PRAGMA mmap_size = " + std::to_string(mmapSize) + ";";
+	sqlite3_int64 effectiveMmapSize = 0;
+	int rc = queryInt64(connectionHandle, sql.c_str(), effectiveMmapSize);
+	if(rc != SQLITE_OK) {
+		return rc;
+	}
+
+	if(effectiveMmapSize < mmapSize) {
+		logger.warn << "mmap_size of " << mmapSize << " bytes requested for database \"" << settings.uri << "\", but sqlite3 maps only " << effectiveMmapSize << " bytes (SQLITE_MAX_MMAP_SIZE)\n";
+	}
+
+	return SQLITE_OK;
+}
+
+sqlite3* ConnectionFactory::openPooledConnectionHandle() {
+	sqlite3* connectionHandle = openConnectionHandle();
+
+	std::unique_ptr<HandleContext>& handleContext = handleContexts[connectionHandle];
+	handleContext.reset(new HandleContext);
+
+	handleContext->hotStatements.reset(new HotStatements(*connectionHandle));
+	for(const auto& sql : settings.hotStatements) {
+		handleContext->hotStatements->add(sql);
+	}
+
+	handleContext->executionControl.reset(new ExecutionControl(*connectionHandle, settings.progressInstructions));
+
+	if(settings.changeCapture || resultCache) {
+		/* the result cache needs the written tables only */
+		handleContext->changeRecorder.reset(new ChangeCapture::Recorder(changeCapture, *connectionHandle, settings.changeCapture, settings.changeCaptureValues));
+	}
+
+	return connectionHandle;
+}
+
+void ConnectionFactory::closeConnectionHandle(sqlite3& connectionHandle) {
+	esl::monitoring::Streams::Location location;
+	location.file = __FILE__;
+	location.function = __func__;
+
+	try {
+		int rc = sqlite3_close(&connectionHandle);
+		if(rc != SQLITE_OK) {
+			logger.warn << "sqlite3_close(...) returned " << rc << ": " << sqlite3_errstr(rc) << "\n";
+			logger.warn << "Trying to close connection with sqlite3_close_v2(...) ...\n";
+			rc = sqlite3_close_v2(&connectionHandle);
+			if(rc != SQLITE_OK) {
+		        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot close database connection", rc, &connectionHandle));
+			}
+		}
+	}
+	catch (const esl::database::exception::SqlError& e) {
+		ESL__LOGGER_WARN_THIS("esl::database::exception::SqlError exception occured\n");
+		ESL__LOGGER_WARN_THIS(e.what(), "\n");
+		location.line = __LINE__;
+		e.getDiagnostics().dump(logger.warn, location);
+
+		const esl::system::Stacktrace* stacktrace = esl::system::Stacktrace::get(e);
+		if(stacktrace) {
+			location.line = __LINE__;
+			stacktrace->dump(logger.warn, location);
+		}
+		else {
+			ESL__LOGGER_WARN_THIS("no stacktrace\n");
+		}
 	}
+	catch(const std::exception& e) {
+		ESL__LOGGER_WARN_THIS("std::exception exception occured\n");
+		ESL__LOGGER_WARN_THIS(e.what(), "\n");
+
+		const esl::system::Stacktrace* stacktrace = esl::system::Stacktrace::get(e);
+		if(stacktrace) {
+			location.line = __LINE__;
+			stacktrace->dump(logger.warn, location);
+		}
+		else {
+			ESL__LOGGER_WARN_THIS("no stacktrace\n");
+		}
+	}
+	catch (...) {
+		ESL__LOGGER_ERROR_THIS("unkown exception occured\n");
+	}
+}
+
+bool ConnectionFactory::isConnectionHandleShared() const {
+	/* a thread safe sqlite3 library shares a single handle between all connections,
+	 * otherwise every connection needs exclusive access to its handle */
+	return settings.maxConnections <= 1 && sqlite3_threadsafe() != 0;
+}
+
+bool ConnectionFactory::withIdleConnectionHandle(const std::function<void(sqlite3&, ExecutionControl&)>& function) {
+	if(isConnectionHandleShared()) {
+		/* createConnection() waits for connectionHandlesMutex, so no connection starts
+		 * using the shared handle until the function returns */
+		std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+		if(connectionHandles.empty() || !maintenanceScheduler || maintenanceScheduler->hasActiveConnections()) {
+			return false;
+		}
+
+		sqlite3* connectionHandle = connectionHandles.front();
+		function(*connectionHandle, *handleContexts[connectionHandle]->executionControl);
+		return true;
+	}
+
+	sqlite3* connectionHandle;
+	ExecutionControl* executionControl;
+	{
+		std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+		if(idleConnectionHandles.empty()) {
+			return false;
+		}
+
+		/* createConnection() takes handles from the back, so the front has been idle longest */
+		connectionHandle = idleConnectionHandles.front();
+		idleConnectionHandles.erase(idleConnectionHandles.begin());
+		executionControl = handleContexts[connectionHandle]->executionControl.get();
+	}
+
+	function(*connectionHandle, *executionControl);
+
+	{
+		std::lock_guard<std::mutex> lock(connectionHandlesMutex);
+		idleConnectionHandles.insert(idleConnectionHandles.begin(), connectionHandle);
+	}
+	connectionHandlesCondition.notify_one();
+
+	return true;
 }
 
 } /* namespace database */
@@ -19,14 +19,30 @@
 #ifndef SQLITE4ESL_DATABASE_CONNECTIONFACTORY_H_
 #define SQLITE4ESL_DATABASE_CONNECTIONFACTORY_H_
 
+#include <sqlite4esl/database/CheckpointScheduler.h>
+#include <sqlite4esl/database/ChangeCapture.h>
+#include <sqlite4esl/database/Function.h>
+#include <sqlite4esl/database/HandleContext.h>
+#include <sqlite4esl/database/InstrumentedVfs.h>
+#include <sqlite4esl/database/MaintenanceScheduler.h>
+#include <sqlite4esl/database/MemoryStatistics.h>
+#include <sqlite4esl/database/QueryPlanRecorder.h>
+#include <sqlite4esl/database/ResultCache.h>
+
 #include <esl/database/Connection.h>
 #include <esl/database/ConnectionFactory.h>
 #include <esl/database/SQLiteConnectionFactory.h>
 
 #include <sqlite3.h>
 
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace sqlite4esl {
 inline namespace v1_6 {
@@ -40,16 +56,78 @@ public:
 	~ConnectionFactory();
 
 	const sqlite3& getConnectionHandle() const;
+	const esl::database::SQLiteConnectionFactory::Settings& getSettings() const noexcept;
 
 	std::unique_ptr<esl::database::Connection> createConnection() override;
 
-	void doUnlock();
+	void releaseConnectionHandle(const sqlite3& connectionHandle);
+
+	/* Installers (functions, modules, ...) are applied to every handle before it is
+	 * handed out by createConnection() */
+	void addInstaller(std::function<void(sqlite3&)> installer);
+	void addFunction(Function function);
+	void install(const sqlite3& connectionHandle);
+
+	/* Prepares "sql" with SQLITE_PREPARE_PERSISTENT on every handle and keeps it pinned */
+	void addHotStatement(const std::string& sql);
+
+	/* Returns nullptr if query plan capture is disabled */
+	QueryPlanRecorder* getQueryPlanRecorder() const noexcept;
+	std::vector<QueryPlan::Report> getQueryPlanReport() const;
+
+	/* Returns empty statistics if the checkpoint scheduler is disabled */
+	CheckpointScheduler::Statistics getCheckpointStatistics() const;
+
+	/* Returns empty statistics if the maintenance scheduler is disabled */
+	MaintenanceScheduler::Statistics getMaintenanceStatistics() const;
+
+	/* Subscribers get the changes of every committed transaction of the handles of this
+	 * factory, requires setting "changeCapture" */
+	std::size_t subscribeChanges(ChangeCapture::Subscriber subscriber);
+	void unsubscribeChanges(std::size_t id);
+
+	/* Returns nullptr if the result cache is disabled */
+	ResultCache* getResultCache() const noexcept;
+
+	/* Sum of the memory statistics of all open handles. Handles in use are reported as of
+	 * their last release and reset on their next release. */
+	MemoryStatistics getMemoryStatistics(bool reset = false) const;
+
+	/* I/O statistics of the database file, its journal and WAL file, requires setting
+	 * "ioStatistics" */
+	std::map<std::string, IoStatistics> getIoStatistics() const;
 
 private:
-	sqlite3* connectionHandle = nullptr;
+	void installPending(sqlite3& connectionHandle);
+	sqlite3* openConnectionHandle();
+	sqlite3* openPooledConnectionHandle();
+	void closeConnectionHandle(sqlite3& connectionHandle);
+	int setMmapSize(sqlite3& connectionHandle);
+	bool isConnectionHandleShared() const;
+	bool withIdleConnectionHandle(const std::function<void(sqlite3&, ExecutionControl&)>& function);
+
 	esl::database::SQLiteConnectionFactory::Settings settings;
-	std::timed_mutex timedMutex;
-	Connection* connection = nullptr;
+	std::string openUri;
+	std::string vfs;
+
+	mutable std::mutex connectionHandlesMutex;
+	std::condition_variable connectionHandlesCondition;
+	std::vector<sqlite3*> connectionHandles;
+	std::vector<sqlite3*> idleConnectionHandles;
+
+	std::vector<std::function<void(sqlite3&)>> installers;
+	std::map<const sqlite3*, std::size_t> installedCount;
+	std::map<const sqlite3*, std::unique_ptr<HandleContext>> handleContexts;
+
+	std::unique_ptr<QueryPlanRecorder> queryPlanRecorder;
+	ChangeCapture changeCapture;
+	std::unique_ptr<ResultCache> resultCache;
+
+	sqlite3* checkpointConnectionHandle = nullptr;
+	std::unique_ptr<CheckpointScheduler> checkpointScheduler;
+
+	sqlite3* maintenanceConnectionHandle = nullptr;
+	std::unique_ptr<MaintenanceScheduler> maintenanceScheduler;
 };
 
 } /* namespace database */
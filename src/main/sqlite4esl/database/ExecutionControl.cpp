@@ -0,0 +1,67 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/ExecutionControl.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+ExecutionControl::ExecutionControl(sqlite3& aConnectionHandle, int instructions)
+: connectionHandle(aConnectionHandle)
+{
+	sqlite3_progress_handler(&connectionHandle, instructions, progressHandler, this);
+}
+
+ExecutionControl::~ExecutionControl() {
+	sqlite3_progress_handler(&connectionHandle, 0, nullptr, nullptr);
+}
+
+void ExecutionControl::arm(const std::chrono::steady_clock::time_point* aDeadline, const CancellationToken* aCancellationToken, const std::atomic<bool>* aInterrupted) noexcept {
+	deadline = aDeadline;
+	cancellationToken = aCancellationToken;
+	interrupted = aInterrupted;
+}
+
+void ExecutionControl::disarm() noexcept {
+	deadline = nullptr;
+	cancellationToken = nullptr;
+	interrupted = nullptr;
+}
+
+int ExecutionControl::progressHandler(void* executionControlPtr) {
+	ExecutionControl& executionControl = *static_cast<ExecutionControl*>(executionControlPtr);
+
+	if(executionControl.cancellationToken && executionControl.cancellationToken->isCancelled()) {
+		return 1;
+	}
+
+	if(executionControl.interrupted && executionControl.interrupted->load()) {
+		return 1;
+	}
+
+	if(executionControl.deadline && std::chrono::steady_clock::now() >= *executionControl.deadline) {
+		return 1;
+	}
+
+	return 0;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
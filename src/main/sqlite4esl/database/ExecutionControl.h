@@ -0,0 +1,76 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_EXECUTIONCONTROL_H_
+#define SQLITE4ESL_DATABASE_EXECUTIONCONTROL_H_
+
+#include <sqlite4esl/database/CancellationToken.h>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Deadline and cancellation of the statements of one handle. A progress handler
+ * checks them every "instructions" virtual machine instructions and interrupts the
+ * running statement, which then fails with SQLITE_INTERRUPT. The limits belong to the
+ * connection of a statement (see Connection::setStatementTimeout()), the statement
+ * arms them for the duration of each step, so connections sharing a handle do not
+ * see each other's limits.
+ * Like the handle itself, an instance must only be used by one thread at a time. */
+class ExecutionControl {
+public:
+	/* Limits of one connection, shared by its statements */
+	struct Limits {
+		/* 0 disables the deadline */
+		std::chrono::milliseconds timeout{0};
+		CancellationToken cancellationToken;
+		/* Set by Connection::interrupt(), cleared when the next execution starts */
+		mutable std::atomic<bool> interrupted{false};
+	};
+
+	ExecutionControl(sqlite3& connectionHandle, int instructions);
+	ExecutionControl(const ExecutionControl&) = delete;
+	~ExecutionControl();
+
+	ExecutionControl& operator=(const ExecutionControl&) = delete;
+
+	/* Interrupts the running statement after "deadline" (nullptr for none), once
+	 * "cancellationToken" (nullptr for none) is cancelled or once "interrupted" (nullptr
+	 * for none) is set until disarm() is called. All have to stay valid until then. */
+	void arm(const std::chrono::steady_clock::time_point* deadline, const CancellationToken* cancellationToken, const std::atomic<bool>* interrupted) noexcept;
+	void disarm() noexcept;
+
+private:
+	static int progressHandler(void* executionControl);
+
+	sqlite3& connectionHandle;
+	const std::chrono::steady_clock::time_point* deadline = nullptr;
+	const CancellationToken* cancellationToken = nullptr;
+	const std::atomic<bool>* interrupted = nullptr;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_EXECUTIONCONTROL_H_ */
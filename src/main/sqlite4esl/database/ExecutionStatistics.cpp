@@ -0,0 +1,122 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/ExecutionStatistics.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+/* Written by its own thread only, read by getSnapshot() */
+struct Shard {
+	std::atomic<std::uint64_t> counters[ExecutionStatistics::counterCount];
+	/* keeps shards of different threads on different cache lines */
+	char padding[64];
+};
+
+struct Registry {
+	std::mutex mutex;
+	std::set<Shard*> shards;
+	std::uint64_t retired[ExecutionStatistics::counterCount] = {};
+};
+
+Registry& getRegistry() {
+	/* never destroyed, threads may terminate after static destruction */
+	static Registry* registry = new Registry;
+	return *registry;
+}
+
+class ShardHolder {
+public:
+	ShardHolder() {
+		for(auto& counter : shard.counters) {
+			counter.store(0, std::memory_order_relaxed);
+		}
+
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.shards.insert(&shard);
+	}
+
+	~ShardHolder() {
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for(std::size_t i = 0; i < ExecutionStatistics::counterCount; ++i) {
+			registry.retired[i] += shard.counters[i].load(std::memory_order_relaxed);
+		}
+		registry.shards.erase(&shard);
+	}
+
+	Shard shard;
+};
+
+thread_local ShardHolder shardHolder;
+}
+
+ExecutionStatistics::Snapshot ExecutionStatistics::Snapshot::operator-(const Snapshot& other) const noexcept {
+	Snapshot result;
+	result.prepares = prepares - other.prepares;
+	result.steps = steps - other.steps;
+	result.rows = rows - other.rows;
+	result.bindings = bindings - other.bindings;
+	result.bytesBound = bytesBound - other.bytesBound;
+	result.bytesFetched = bytesFetched - other.bytesFetched;
+	return result;
+}
+
+void ExecutionStatistics::add(Counter counter, std::uint64_t value) noexcept {
+	/* single writer per shard, so a relaxed load and store is enough */
+	std::atomic<std::uint64_t>& shardCounter = shardHolder.shard.counters[counter];
+	shardCounter.store(shardCounter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+ExecutionStatistics::Snapshot ExecutionStatistics::getSnapshot() {
+	std::uint64_t counters[counterCount];
+
+	{
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		for(std::size_t i = 0; i < counterCount; ++i) {
+			counters[i] = registry.retired[i];
+		}
+		for(auto shard : registry.shards) {
+			for(std::size_t i = 0; i < counterCount; ++i) {
+				counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	Snapshot snapshot;
+	snapshot.prepares = counters[prepares];
+	snapshot.steps = counters[steps];
+	snapshot.rows = counters[rows];
+	snapshot.bindings = counters[bindings];
+	snapshot.bytesBound = counters[bytesBound];
+	snapshot.bytesFetched = counters[bytesFetched];
+	return snapshot;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
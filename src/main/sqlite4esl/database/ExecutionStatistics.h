@@ -0,0 +1,64 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_EXECUTIONSTATISTICS_H_
+#define SQLITE4ESL_DATABASE_EXECUTIONSTATISTICS_H_
+
+#include <cstdint>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Process wide counters of statement execution. Every thread increments its own
+ * shard without contention; getSnapshot() sums the shards of all threads, including
+ * the counts of threads that have terminated already. */
+class ExecutionStatistics {
+public:
+	/* bytesBound and bytesFetched count text and blob values */
+	enum Counter {
+		prepares,
+		steps,
+		rows,
+		bindings,
+		bytesBound,
+		bytesFetched,
+		counterCount
+	};
+
+	struct Snapshot {
+		std::uint64_t prepares = 0;
+		std::uint64_t steps = 0;
+		std::uint64_t rows = 0;
+		std::uint64_t bindings = 0;
+		std::uint64_t bytesBound = 0;
+		std::uint64_t bytesFetched = 0;
+
+		/* Difference of two snapshots, e.g. the counts of an interval */
+		Snapshot operator-(const Snapshot& other) const noexcept;
+	};
+
+	static void add(Counter counter, std::uint64_t value = 1) noexcept;
+	static Snapshot getSnapshot();
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_EXECUTIONSTATISTICS_H_ */
@@ -0,0 +1,471 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/Exporter.h>
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ExecutionStatistics.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <cerrno>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const char hexDigits[] = "0123456789abcdef";
+}
+
+Exporter::Exporter(Format aFormat, Sink aSink, std::size_t bufferSize)
+: format(aFormat),
+  sink(std::move(aSink)),
+  buffer(bufferSize < 64 ? 64 : bufferSize)
+{
+	if(!sink) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Exporter requires a sink"));
+	}
+}
+
+Exporter::Sink Exporter::toFileDescriptor(int fileDescriptor) {
+	return [fileDescriptor](const char* data, std::size_t size) {
+		while(size > 0) {
+			ssize_t written = ::write(fileDescriptor, data, size);
+			if(written < 0) {
+				if(errno == EINTR) {
+					continue;
+				}
+		        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Cannot write export to file descriptor: ") + std::strerror(errno)));
+			}
+			data += written;
+			size -= static_cast<std::size_t>(written);
+		}
+	};
+}
+
+Exporter& Exporter::setHeader(bool aHeader) {
+	header = aHeader;
+	return *this;
+}
+
+Exporter& Exporter::setDelimiter(char aDelimiter) {
+	delimiter = aDelimiter;
+	return *this;
+}
+
+Exporter& Exporter::setNullValue(std::string aNullValue) {
+	nullValue = std::move(aNullValue);
+	return *this;
+}
+
+std::uint64_t Exporter::exportRows(const StatementHandle& statementHandle) {
+	sqlite3_stmt& statement = statementHandle.getHandle();
+	std::size_t columnCount = static_cast<std::size_t>(sqlite3_column_count(&statement));
+	std::uint64_t rows = 0;
+
+	begin(statement, columnCount);
+	while(statementHandle.step()) {
+		switch(format) {
+		case Format::csv:
+			writeCsvRow(statement, columnCount);
+			break;
+		case Format::ndjson:
+			writeNdjsonRow(statement, columnCount);
+			break;
+		case Format::binary:
+			writeBinaryRow(statement, columnCount);
+			break;
+		}
+		++rows;
+	}
+	end();
+
+	ExecutionStatistics::add(ExecutionStatistics::bytesFetched, bytesFetched);
+	bytesFetched = 0;
+
+	statementHandle.reset();
+	return rows;
+}
+
+std::uint64_t Exporter::exportRows(const Connection& connection, const std::string& sql) {
+	StatementHandle statementHandle = connection.prepareSQLite(sql);
+	return exportRows(statementHandle);
+}
+
+void Exporter::begin(sqlite3_stmt& statement, std::size_t columnCount) {
+	switch(format) {
+	case Format::csv:
+		if(header) {
+			for(std::size_t i = 0; i < columnCount; ++i) {
+				if(i > 0) {
+					append(delimiter);
+				}
+				const char* name = sqlite3_column_name(&statement, static_cast<int>(i));
+				writeCsvText(name, std::strlen(name));
+			}
+			append("\r\n", 2);
+		}
+		break;
+
+	case Format::ndjson: {
+		/* escape the keys once, they are copied into every row */
+		std::vector<char> rowBuffer;
+		rowBuffer.swap(buffer);
+		std::size_t rowBufferUsed = bufferUsed;
+
+		keys.clear();
+		keys.reserve(columnCount);
+		for(std::size_t i = 0; i < columnCount; ++i) {
+			const char* name = sqlite3_column_name(&statement, static_cast<int>(i));
+			std::size_t size = std::strlen(name);
+
+			buffer.assign(size * 6 + 4, 0);
+			bufferUsed = 0;
+			writeJsonString(name, size);
+			append(':');
+			keys.emplace_back(buffer.data(), bufferUsed);
+		}
+
+		buffer.swap(rowBuffer);
+		bufferUsed = rowBufferUsed;
+		break;
+	}
+
+	case Format::binary:
+		append("S4EB", 4);
+		append(static_cast<char>(1));
+		writeUInt32(static_cast<std::uint32_t>(columnCount));
+		for(std::size_t i = 0; i < columnCount; ++i) {
+			const char* name = sqlite3_column_name(&statement, static_cast<int>(i));
+			std::size_t size = std::strlen(name);
+			writeUInt32(static_cast<std::uint32_t>(size));
+			append(name, size);
+		}
+		break;
+	}
+}
+
+void Exporter::end() {
+	if(format == Format::binary) {
+		append(static_cast<char>(0));
+	}
+	flush();
+}
+
+void Exporter::writeCsvRow(sqlite3_stmt& statement, std::size_t columnCount) {
+	for(std::size_t i = 0; i < columnCount; ++i) {
+		int index = static_cast<int>(i);
+		if(i > 0) {
+			append(delimiter);
+		}
+
+		switch(sqlite3_column_type(&statement, index)) {
+		case SQLITE_INTEGER:
+			writeInteger(sqlite3_column_int64(&statement, index));
+			break;
+		case SQLITE_FLOAT:
+			writeDouble(sqlite3_column_double(&statement, index));
+			break;
+		case SQLITE_TEXT: {
+			const char* data = reinterpret_cast<const char*>(sqlite3_column_text(&statement, index));
+			std::size_t size = static_cast<std::size_t>(sqlite3_column_bytes(&statement, index));
+			writeCsvText(data, size);
+			bytesFetched += size;
+			break;
+		}
+		case SQLITE_BLOB: {
+			/* hex encoded, never needs quoting */
+			const unsigned char* data = static_cast<const unsigned char*>(sqlite3_column_blob(&statement, index));
+			std::size_t size = static_cast<std::size_t>(sqlite3_column_bytes(&statement, index));
+			bytesFetched += size;
+			for(std::size_t j = 0; j < size; ++j) {
+				append(hexDigits[data[j] >> 4]);
+				append(hexDigits[data[j] & 0x0f]);
+			}
+			break;
+		}
+		default:
+			append(nullValue.data(), nullValue.size());
+			break;
+		}
+	}
+	append("\r\n", 2);
+}
+
+void Exporter::writeCsvText(const char* data, std::size_t size) {
+	bool quote = false;
+	for(std::size_t i = 0; i < size; ++i) {
+		char c = data[i];
+		if(c == delimiter || c == '"' || c == '\r' || c == '\n') {
+			quote = true;
+			break;
+		}
+	}
+
+	if(!quote) {
+		append(data, size);
+		return;
+	}
+
+	append('"');
+	for(std::size_t i = 0; i < size; ++i) {
+		if(data[i] == '"') {
+			append('"');
+		}
+		append(data[i]);
+	}
+	append('"');
+}
+
+void Exporter::writeNdjsonRow(sqlite3_stmt& statement, std::size_t columnCount) {
+	append('{');
+	for(std::size_t i = 0; i < columnCount; ++i) {
+		int index = static_cast<int>(i);
+		if(i > 0) {
+			append(',');
+		}
+		append(keys[i].data(), keys[i].size());
+
+		switch(sqlite3_column_type(&statement, index)) {
+		case SQLITE_INTEGER:
+			writeInteger(sqlite3_column_int64(&statement, index));
+			break;
+		case SQLITE_FLOAT: {
+			double value = sqlite3_column_double(&statement, index);
+			if(std::isfinite(value)) {
+				writeDouble(value);
+			}
+			else {
+				append("null", 4);
+			}
+			break;
+		}
+		case SQLITE_TEXT: {
+			const char* data = reinterpret_cast<const char*>(sqlite3_column_text(&statement, index));
+			std::size_t size = static_cast<std::size_t>(sqlite3_column_bytes(&statement, index));
+			writeJsonString(data, size);
+			bytesFetched += size;
+			break;
+		}
+		case SQLITE_BLOB: {
+			/* base64 encoded string */
+			const unsigned char* data = static_cast<const unsigned char*>(sqlite3_column_blob(&statement, index));
+			std::size_t size = static_cast<std::size_t>(sqlite3_column_bytes(&statement, index));
+			append('"');
+			writeBase64(data, size);
+			append('"');
+			bytesFetched += size;
+			break;
+		}
+		default:
+			append("null", 4);
+			break;
+		}
+	}
+	append("}\n", 2);
+}
+
+void Exporter::writeJsonString(const char* data, std::size_t size) {
+	append('"');
+	for(std::size_t i = 0; i < size; ++i) {
+		unsigned char c = static_cast<unsigned char>(data[i]);
+		switch(c) {
+		case '"':
+			append("\\\"", 2);
+			break;
+		case '\\':
+			append("\\\\", 2);
+			break;
+		case '\n':
+			append("\\n", 2);
+			break;
+		case '\r':
+			append("\\r", 2);
+			break;
+		case '\t':
+			append("\\t", 2);
+			break;
+		default:
+			if(c < 0x20) {
+				append("\\u00", 4);
+				append(hexDigits[c >> 4]);
+				append(hexDigits[c & 0x0f]);
+			}
+			else {
+				append(static_cast<char>(c));
+			}
+			break;
+		}
+	}
+	append('"');
+}
+
+void Exporter::writeBinaryRow(sqlite3_stmt& statement, std::size_t columnCount) {
+	append(static_cast<char>(1));
+	for(std::size_t i = 0; i < columnCount; ++i) {
+		int index = static_cast<int>(i);
+		int type = sqlite3_column_type(&statement, index);
+
+		append(static_cast<char>(type));
+		switch(type) {
+		case SQLITE_INTEGER:
+			writeUInt64(static_cast<std::uint64_t>(sqlite3_column_int64(&statement, index)));
+			break;
+		case SQLITE_FLOAT: {
+			double value = sqlite3_column_double(&statement, index);
+			std::uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			writeUInt64(bits);
+			break;
+		}
+		case SQLITE_TEXT: {
+			const char* data = reinterpret_cast<const char*>(sqlite3_column_text(&statement, index));
+			std::size_t size = static_cast<std::size_t>(sqlite3_column_bytes(&statement, index));
+			writeUInt32(static_cast<std::uint32_t>(size));
+			append(data, size);
+			bytesFetched += size;
+			break;
+		}
+		case SQLITE_BLOB: {
+			const char* data = static_cast<const char*>(sqlite3_column_blob(&statement, index));
+			std::size_t size = static_cast<std::size_t>(sqlite3_column_bytes(&statement, index));
+			writeUInt32(static_cast<std::uint32_t>(size));
+			append(data, size);
+			bytesFetched += size;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+void Exporter::writeInteger(std::int64_t value) {
+	char digits[24];
+	char* end = digits + sizeof(digits);
+	char* begin = end;
+
+	/* negate as unsigned to handle INT64_MIN */
+	std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+	do {
+		*--begin = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while(magnitude > 0);
+	if(value < 0) {
+		*--begin = '-';
+	}
+
+	append(begin, static_cast<std::size_t>(end - begin));
+}
+
+void Exporter::writeDouble(double value) {
+	char digits[32];
+	int size = std::snprintf(digits, sizeof(digits), "%.17g", value);
+	if(size <= 0) {
+		return;
+	}
+
+	/* snprintf uses the decimal point of the C locale, CSV and JSON require '.' */
+	const char* decimalPoint = std::localeconv()->decimal_point;
+	std::size_t decimalPointSize = std::strlen(decimalPoint);
+	if(decimalPointSize > 0 && std::strcmp(decimalPoint, ".") != 0) {
+		char* position = std::strstr(digits, decimalPoint);
+		if(position) {
+			*position = '.';
+			std::memmove(position + 1, position + decimalPointSize, std::strlen(position + decimalPointSize) + 1);
+			size -= static_cast<int>(decimalPointSize) - 1;
+		}
+	}
+	append(digits, static_cast<std::size_t>(size));
+}
+
+void Exporter::writeBase64(const unsigned char* data, std::size_t size) {
+	std::size_t i = 0;
+	for(; i + 2 < size; i += 3) {
+		std::uint32_t triple = (static_cast<std::uint32_t>(data[i]) << 16) | (static_cast<std::uint32_t>(data[i + 1]) << 8) | data[i + 2];
+		append(base64Alphabet[(triple >> 18) & 0x3f]);
+		append(base64Alphabet[(triple >> 12) & 0x3f]);
+		append(base64Alphabet[(triple >> 6) & 0x3f]);
+		append(base64Alphabet[triple & 0x3f]);
+	}
+
+	if(i + 1 == size) {
+		std::uint32_t triple = static_cast<std::uint32_t>(data[i]) << 16;
+		append(base64Alphabet[(triple >> 18) & 0x3f]);
+		append(base64Alphabet[(triple >> 12) & 0x3f]);
+		append("==", 2);
+	}
+	else if(i + 2 == size) {
+		std::uint32_t triple = (static_cast<std::uint32_t>(data[i]) << 16) | (static_cast<std::uint32_t>(data[i + 1]) << 8);
+		append(base64Alphabet[(triple >> 18) & 0x3f]);
+		append(base64Alphabet[(triple >> 12) & 0x3f]);
+		append(base64Alphabet[(triple >> 6) & 0x3f]);
+		append('=');
+	}
+}
+
+void Exporter::writeUInt32(std::uint32_t value) {
+	char bytes[4];
+	for(std::size_t i = 0; i < sizeof(bytes); ++i) {
+		bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+	}
+	append(bytes, sizeof(bytes));
+}
+
+void Exporter::writeUInt64(std::uint64_t value) {
+	char bytes[8];
+	for(std::size_t i = 0; i < sizeof(bytes); ++i) {
+		bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+	}
+	append(bytes, sizeof(bytes));
+}
+
+void Exporter::append(const char* data, std::size_t size) {
+	if(bufferUsed + size > buffer.size()) {
+		flush();
+
+		/* values larger than the buffer are passed through */
+		if(size > buffer.size()) {
+			sink(data, size);
+			return;
+		}
+	}
+
+	std::memcpy(buffer.data() + bufferUsed, data, size);
+	bufferUsed += size;
+}
+
+void Exporter::flush() {
+	if(bufferUsed > 0) {
+		std::size_t size = bufferUsed;
+		bufferUsed = 0;
+		sink(buffer.data(), size);
+	}
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
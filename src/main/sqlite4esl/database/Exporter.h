@@ -0,0 +1,117 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_EXPORTER_H_
+#define SQLITE4ESL_DATABASE_EXPORTER_H_
+
+#include <sqlite4esl/database/StatementHandle.h>
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+class Connection;
+
+/* Streams the rows of a statement into a reusable buffer, reading directly from
+ * sqlite3_column_*. The buffer is handed to the sink whenever it is full and at
+ * the end of an export. No memory is allocated per row or per cell.
+ *
+ * Binary format (all integers little endian):
+ *   header: "S4EB", u8 version (1), u32 column count, per column: u32 length + name
+ *   row:    u8 1, then per column: u8 type (SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT,
+ *           SQLITE_BLOB, SQLITE_NULL) followed by i64, IEEE 754 double or u32 length + bytes
+ *   end:    u8 0 */
+class Exporter {
+public:
+	enum class Format {
+		csv,
+		ndjson,
+		binary
+	};
+
+	using Sink = std::function<void(const char* data, std::size_t size)>;
+
+	Exporter(Format format, Sink sink, std::size_t bufferSize = 1024 * 1024);
+
+	/* Sink writing to a file descriptor, the descriptor is not closed */
+	static Sink toFileDescriptor(int fileDescriptor);
+
+	/* CSV only */
+	Exporter& setHeader(bool header);
+	Exporter& setDelimiter(char delimiter);
+	Exporter& setNullValue(std::string nullValue);
+
+	/* Steps the statement until it is done and returns the number of exported rows.
+	 * The statement is reset afterwards. */
+	std::uint64_t exportRows(const StatementHandle& statementHandle);
+	std::uint64_t exportRows(const Connection& connection, const std::string& sql);
+
+private:
+	void begin(sqlite3_stmt& statement, std::size_t columnCount);
+	void end();
+
+	void writeCsvRow(sqlite3_stmt& statement, std::size_t columnCount);
+	void writeCsvText(const char* data, std::size_t size);
+	void writeNdjsonRow(sqlite3_stmt& statement, std::size_t columnCount);
+	void writeJsonString(const char* data, std::size_t size);
+	void writeBinaryRow(sqlite3_stmt& statement, std::size_t columnCount);
+
+	void writeInteger(std::int64_t value);
+	void writeDouble(double value);
+	void writeBase64(const unsigned char* data, std::size_t size);
+	void writeUInt32(std::uint32_t value);
+	void writeUInt64(std::uint64_t value);
+
+	void append(char c) {
+		if(bufferUsed == buffer.size()) {
+			flush();
+		}
+		buffer[bufferUsed++] = c;
+	}
+	void append(const char* data, std::size_t size);
+	void flush();
+
+	Format format;
+	Sink sink;
+	std::vector<char> buffer;
+	std::size_t bufferUsed = 0;
+
+	bool header = true;
+	char delimiter = ',';
+	std::string nullValue;
+
+	/* text and blob bytes read during the current export */
+	std::uint64_t bytesFetched = 0;
+
+	/* NDJSON: escaped column names including quotes and colon */
+	std::vector<std::string> keys;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_EXPORTER_H_ */
@@ -0,0 +1,122 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/Function.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <stdexcept>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+void resultError(sqlite3_context* context) {
+	try {
+		throw;
+	}
+	catch(const std::bad_alloc&) {
+		sqlite3_result_error_nomem(context);
+	}
+	catch(const std::exception& e) {
+		sqlite3_result_error(context, e.what(), -1);
+	}
+	catch(...) {
+		sqlite3_result_error(context, "unknown exception occurred in application defined function", -1);
+	}
+}
+
+void call(const Function::Call& function, sqlite3_context* context, int argc, sqlite3_value** argv) {
+	try {
+		function(*context, argc, argv);
+	}
+	catch(...) {
+		resultError(context);
+	}
+}
+
+void call(const Function::Result& function, sqlite3_context* context) {
+	try {
+		function(*context);
+	}
+	catch(...) {
+		resultError(context);
+	}
+}
+}
+
+Function::Function(std::string aName, int aArgumentCount, bool aDeterministic)
+: name(std::move(aName)),
+  argumentCount(aArgumentCount),
+  deterministic(aDeterministic)
+{ }
+
+const std::string& Function::getName() const noexcept {
+	return name;
+}
+
+int Function::getArgumentCount() const noexcept {
+	return argumentCount;
+}
+
+void Function::install(sqlite3& connectionHandle) const {
+	struct Callbacks {
+		static void scalar(sqlite3_context* context, int argc, sqlite3_value** argv) {
+			call(static_cast<const Function*>(sqlite3_user_data(context))->scalarCall, context, argc, argv);
+		}
+		static void step(sqlite3_context* context, int argc, sqlite3_value** argv) {
+			call(static_cast<const Function*>(sqlite3_user_data(context))->stepCall, context, argc, argv);
+		}
+		static void inverse(sqlite3_context* context, int argc, sqlite3_value** argv) {
+			call(static_cast<const Function*>(sqlite3_user_data(context))->inverseCall, context, argc, argv);
+		}
+		static void value(sqlite3_context* context) {
+			call(static_cast<const Function*>(sqlite3_user_data(context))->valueCall, context);
+		}
+		static void final(sqlite3_context* context) {
+			call(static_cast<const Function*>(sqlite3_user_data(context))->finalCall, context);
+		}
+	};
+
+	int flags = SQLITE_UTF8;
+	if(deterministic) {
+		flags |= SQLITE_DETERMINISTIC;
+	}
+
+	int rc;
+	void* userData = const_cast<Function*>(this);
+	if(scalarCall) {
+		rc = sqlite3_create_function_v2(&connectionHandle, name.c_str(), argumentCount, flags, userData, Callbacks::scalar, nullptr, nullptr, nullptr);
+	}
+	else if(inverseCall) {
+		rc = sqlite3_create_window_function(&connectionHandle, name.c_str(), argumentCount, flags, userData, Callbacks::step, Callbacks::final, Callbacks::value, Callbacks::inverse, nullptr);
+	}
+	else {
+		rc = sqlite3_create_function_v2(&connectionHandle, name.c_str(), argumentCount, flags, userData, nullptr, Callbacks::step, Callbacks::final, nullptr);
+	}
+
+	if(rc != SQLITE_OK) {
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Can't register function \"" + name + "\"", rc, &connectionHandle));
+	}
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,205 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_FUNCTION_H_
+#define SQLITE4ESL_DATABASE_FUNCTION_H_
+
+#include <sqlite4esl/database/Value.h>
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Application defined SQL function, registered on every handle of a ConnectionFactory.
+ *
+ *   Function::scalar<std::int64_t(const std::string&)>("strlen", [](const std::string& s) { ... }, true);
+ *   Function::aggregate<State, double(double)>("median", step, final);
+ *   Function::window<State, double(double)>("msum", step, inverse, value, final);
+ *
+ * Aggregate and window functions keep one default constructed "State" per group,
+ * "step" and "inverse" are called as void(State&, Args...), "value" and "final" as
+ * R(State&). */
+class Function {
+public:
+	using Call = std::function<void(sqlite3_context&, int, sqlite3_value**)>;
+	using Result = std::function<void(sqlite3_context&)>;
+
+	template<typename Signature, typename Callable>
+	static Function scalar(std::string name, Callable callable, bool deterministic = false);
+
+	template<typename State, typename Signature, typename Step, typename Final>
+	static Function aggregate(std::string name, Step step, Final final, bool deterministic = false);
+
+	template<typename State, typename Signature, typename Step, typename Inverse, typename Current, typename Final>
+	static Function window(std::string name, Step step, Inverse inverse, Current value, Final final, bool deterministic = false);
+
+	const std::string& getName() const noexcept;
+	int getArgumentCount() const noexcept;
+
+	void install(sqlite3& connectionHandle) const;
+
+private:
+	template<std::size_t... I>
+	struct IndexSequence { };
+
+	template<std::size_t N, std::size_t... I>
+	struct MakeIndexSequence : MakeIndexSequence<N-1, N-1, I...> { };
+
+	template<std::size_t... I>
+	struct MakeIndexSequence<0, I...> {
+		using type = IndexSequence<I...>;
+	};
+
+	template<typename Signature>
+	struct Traits;
+
+	template<typename R, typename... Args>
+	struct Traits<R(Args...)> {
+		using Return = R;
+		static constexpr int argumentCount = sizeof...(Args);
+		using Indices = typename MakeIndexSequence<sizeof...(Args)>::type;
+
+		template<typename Callable, std::size_t... I>
+		static R call(Callable& callable, sqlite3_value** argv, IndexSequence<I...>) {
+			return callable(Value<typename std::decay<Args>::type>::get(*argv[I])...);
+		}
+
+		template<typename State, typename Callable, std::size_t... I>
+		static void callWithState(Callable& callable, State& state, sqlite3_value** argv, IndexSequence<I...>) {
+			callable(state, Value<typename std::decay<Args>::type>::get(*argv[I])...);
+		}
+	};
+
+	template<typename R>
+	struct ResultSetter {
+		template<typename Callable>
+		static void set(sqlite3_context& context, Callable callable) {
+			Value<typename std::decay<R>::type>::result(context, callable());
+		}
+	};
+
+	template<typename State>
+	static State* getState(sqlite3_context& context, bool create);
+
+	Function(std::string name, int argumentCount, bool deterministic);
+
+	std::string name;
+	int argumentCount;
+	bool deterministic;
+
+	Call scalarCall;
+	Call stepCall;
+	Call inverseCall;
+	Result valueCall;
+	Result finalCall;
+};
+
+template<>
+struct Function::ResultSetter<void> {
+	template<typename Callable>
+	static void set(sqlite3_context& context, Callable callable) {
+		callable();
+		sqlite3_result_null(&context);
+	}
+};
+
+template<typename Signature, typename Callable>
+Function Function::scalar(std::string name, Callable callable, bool deterministic) {
+	using Return = typename Traits<Signature>::Return;
+
+	Function function(std::move(name), Traits<Signature>::argumentCount, deterministic);
+	function.scalarCall = [callable](sqlite3_context& context, int, sqlite3_value** argv) mutable {
+		ResultSetter<Return>::set(context, [&callable, argv]() -> Return {
+			return Traits<Signature>::call(callable, argv, typename Traits<Signature>::Indices());
+		});
+	};
+	return function;
+}
+
+template<typename State, typename Signature, typename Step, typename Final>
+Function Function::aggregate(std::string name, Step step, Final final, bool deterministic) {
+	using Return = typename Traits<Signature>::Return;
+
+	Function function(std::move(name), Traits<Signature>::argumentCount, deterministic);
+	function.stepCall = [step](sqlite3_context& context, int, sqlite3_value** argv) mutable {
+		Traits<Signature>::callWithState(step, *getState<State>(context, true), argv, typename Traits<Signature>::Indices());
+	};
+	function.finalCall = [final](sqlite3_context& context) mutable {
+		std::unique_ptr<State> state(getState<State>(context, false));
+		if(!state) {
+			/* no rows have been aggregated */
+			state.reset(new State());
+		}
+		ResultSetter<Return>::set(context, [&final, &state]() -> Return {
+			return final(*state);
+		});
+	};
+	return function;
+}
+
+template<typename State, typename Signature, typename Step, typename Inverse, typename Current, typename Final>
+Function Function::window(std::string name, Step step, Inverse inverse, Current value, Final final, bool deterministic) {
+	using Return = typename Traits<Signature>::Return;
+
+	Function function(aggregate<State, Signature>(std::move(name), std::move(step), std::move(final), deterministic));
+	function.inverseCall = [inverse](sqlite3_context& context, int, sqlite3_value** argv) mutable {
+		Traits<Signature>::callWithState(inverse, *getState<State>(context, true), argv, typename Traits<Signature>::Indices());
+	};
+	function.valueCall = [value](sqlite3_context& context) mutable {
+		State* state = getState<State>(context, false);
+		State emptyState;
+		ResultSetter<Return>::set(context, [&value, state, &emptyState]() -> Return {
+			return value(state ? *state : emptyState);
+		});
+	};
+	return function;
+}
+
+template<typename State>
+State* Function::getState(sqlite3_context& context, bool create) {
+	/* sqlite3 keeps a zero initialized pointer per group, the state itself is owned by
+	 * the final call */
+	State** statePtr = static_cast<State**>(sqlite3_aggregate_context(&context, create ? sizeof(State*) : 0));
+	if(statePtr == nullptr) {
+		if(create) {
+			throw std::bad_alloc();
+		}
+		return nullptr;
+	}
+
+	if(*statePtr == nullptr && create) {
+		*statePtr = new State();
+	}
+	return *statePtr;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_FUNCTION_H_ */
@@ -0,0 +1,63 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_HANDLECONTEXT_H_
+#define SQLITE4ESL_DATABASE_HANDLECONTEXT_H_
+
+#include <sqlite4esl/database/ChangeCapture.h>
+#include <sqlite4esl/database/ExecutionControl.h>
+#include <sqlite4esl/database/HotStatements.h>
+#include <sqlite4esl/database/MemoryStatistics.h>
+
+#include <cstddef>
+#include <memory>
+#include <set>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+class PreparedBulkStatementBinding;
+
+/* Objects bound to one pooled handle. They are created when the handle is opened and
+ * destroyed before it is closed. Like the handle they are used by one thread at a time. */
+struct HandleContext {
+	std::unique_ptr<HotStatements> hotStatements;
+	std::unique_ptr<ExecutionControl> executionControl;
+	/* nullptr if change capture and the result cache are disabled */
+	std::unique_ptr<ChangeCapture::Recorder> changeRecorder;
+
+	/* connections using the handle, more than one if it is shared (guarded by the
+	 * handle mutex of the connection factory) */
+	std::size_t connections = 0;
+	/* memory statistics as of the last release of the handle by its last connection,
+	 * reported while it is in use */
+	MemoryStatistics memoryStatistics;
+	/* reset requested while the handle was in use, done on its release by the last connection */
+	bool memoryStatisticsReset = false;
+
+	/* bulk statements with buffered rows, they are flushed before any statement of the
+	 * handle is stepped */
+	std::set<PreparedBulkStatementBinding*> bufferingBulkStatements;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_HANDLECONTEXT_H_ */
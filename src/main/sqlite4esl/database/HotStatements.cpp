@@ -0,0 +1,90 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/HotStatements.h>
+
+#include <esl/Logger.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::HotStatements");
+}
+
+HotStatements::HotStatements(sqlite3& aConnectionHandle)
+: connectionHandle(aConnectionHandle)
+{ }
+
+HotStatements::~HotStatements() {
+	for(auto& entry : entries) {
+		if(entry.second.inUse) {
+			logger.warn << "Pinned statement \"" << entry.first << "\" is still in use while its handle is closed\n";
+		}
+		sqlite3_finalize(entry.second.statement);
+	}
+}
+
+void HotStatements::add(const std::string& sql) {
+	Entry& entry = entries[sql];
+	if(entry.statement == nullptr) {
+		prepare(sql, entry);
+	}
+}
+
+sqlite3_stmt* HotStatements::acquire(const std::string& sql) {
+	auto iter = entries.find(sql);
+	if(iter == entries.end() || iter->second.inUse) {
+		return nullptr;
+	}
+
+	if(iter->second.statement == nullptr && !prepare(sql, iter->second)) {
+		return nullptr;
+	}
+
+	iter->second.inUse = true;
+	return iter->second.statement;
+}
+
+void HotStatements::release(sqlite3_stmt& statement) noexcept {
+	sqlite3_reset(&statement);
+	sqlite3_clear_bindings(&statement);
+
+	for(auto& entry : entries) {
+		if(entry.second.statement == &statement) {
+			entry.second.inUse = false;
+			return;
+		}
+	}
+}
+
+bool HotStatements::prepare(const std::string& sql, Entry& entry) {
+	int rc = sqlite3_prepare_v3(&connectionHandle, sql.c_str(), static_cast<int>(sql.size() + 1), SQLITE_PREPARE_PERSISTENT, &entry.statement, nullptr);
+	if(rc != SQLITE_OK) {
+		logger.debug << "Cannot prepare pinned statement \"" << sql << "\" yet: " << sqlite3_errmsg(&connectionHandle) << "\n";
+		sqlite3_finalize(entry.statement);
+		entry.statement = nullptr;
+		return false;
+	}
+	return entry.statement != nullptr;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
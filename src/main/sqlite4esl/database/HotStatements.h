@@ -0,0 +1,67 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_HOTSTATEMENTS_H_
+#define SQLITE4ESL_DATABASE_HOTSTATEMENTS_H_
+
+#include <sqlite3.h>
+
+#include <map>
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Statements of one handle that are prepared in advance with SQLITE_PREPARE_PERSISTENT
+ * and kept for the lifetime of the handle. Connection::prepareSQLite() hands out the
+ * pinned statement if it is not in use already, StatementHandle gives it back.
+ * Like the handle itself, an instance must only be used by one thread at a time. */
+class HotStatements {
+public:
+	HotStatements(sqlite3& connectionHandle);
+	HotStatements(const HotStatements&) = delete;
+	~HotStatements();
+
+	HotStatements& operator=(const HotStatements&) = delete;
+
+	/* A statement that cannot be prepared yet (e.g. its table does not exist) is
+	 * prepared again when it is requested */
+	void add(const std::string& sql);
+
+	/* Returns nullptr if "sql" is not pinned or the pinned statement is in use */
+	sqlite3_stmt* acquire(const std::string& sql);
+	void release(sqlite3_stmt& statement) noexcept;
+
+private:
+	struct Entry {
+		sqlite3_stmt* statement = nullptr;
+		bool inUse = false;
+	};
+
+	bool prepare(const std::string& sql, Entry& entry);
+
+	sqlite3& connectionHandle;
+	std::map<std::string, Entry> entries;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_HOTSTATEMENTS_H_ */
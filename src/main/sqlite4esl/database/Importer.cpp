@@ -0,0 +1,719 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/Importer.h>
+#include <sqlite4esl/database/ExecutionStatistics.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <esl/Logger.h>
+#include <esl/system/Stacktrace.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::Importer");
+
+std::string quoteIdentifier(const std::string& identifier) {
+	std::string result = "\"";
+	for(char c : identifier) {
+		if(c == '"') {
+			result += '"';
+		}
+		result += c;
+	}
+	return result + "\"";
+}
+
+void execute(const Connection& connection, const std::string& sql) {
+	StatementHandle statementHandle = connection.prepareSQLite(sql);
+	statementHandle.step();
+}
+
+class FileInput {
+public:
+	FileInput(int aFileDescriptor)
+	: fileDescriptor(aFileDescriptor),
+	  buffer(1024 * 1024)
+	{ }
+
+	/* returns -1 at the end of the input */
+	int get() {
+		if(position == size && !fill()) {
+			return -1;
+		}
+		return static_cast<unsigned char>(buffer[position++]);
+	}
+
+	/* puts back the last character returned by get() */
+	void unget() noexcept {
+		--position;
+	}
+
+	void read(char* data, std::size_t dataSize) {
+		while(dataSize > 0) {
+			if(position == size && !fill()) {
+		        throw esl::system::Stacktrace::add(std::runtime_error("Unexpected end of import input"));
+			}
+			std::size_t count = std::min(dataSize, size - position);
+			std::memcpy(data, buffer.data() + position, count);
+			position += count;
+			data += count;
+			dataSize -= count;
+		}
+	}
+
+	std::uint64_t readUInt(std::size_t bytes) {
+		char data[8];
+		read(data, bytes);
+
+		std::uint64_t value = 0;
+		for(std::size_t i = 0; i < bytes; ++i) {
+			value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+		}
+		return value;
+	}
+
+private:
+	bool fill() {
+		for(;;) {
+			ssize_t count = ::read(fileDescriptor, buffer.data(), buffer.size());
+			if(count < 0) {
+				if(errno == EINTR) {
+					continue;
+				}
+		        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Cannot read import input: ") + std::strerror(errno)));
+			}
+			position = 0;
+			size = static_cast<std::size_t>(count);
+			return size > 0;
+		}
+	}
+
+	int fileDescriptor;
+	std::vector<char> buffer;
+	std::size_t position = 0;
+	std::size_t size = 0;
+};
+
+/* Target of the CSV parser to collect the header line */
+struct HeaderRow {
+	void beginValue(int) {
+		names.emplace_back();
+	}
+	void appendValue(char c) {
+		names.back() += c;
+	}
+	void endValue(bool) {
+	}
+	void endRow() {
+	}
+
+	std::vector<std::string> names;
+};
+
+class CsvReader {
+public:
+	CsvReader(int fileDescriptor, char aDelimiter, bool aHeader)
+	: input(fileDescriptor),
+	  delimiter(aDelimiter),
+	  header(aHeader)
+	{ }
+
+	bool read(Importer::Batch& batch) {
+		if(header) {
+			header = false;
+
+			HeaderRow headerRow;
+			if(!parseRow(headerRow)) {
+				return false;
+			}
+			batch.setColumnNames(std::move(headerRow.names));
+		}
+
+		while(!batch.isFull()) {
+			if(!parseRow(batch)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	template<typename Target>
+	bool parseRow(Target& target) {
+		int c = input.get();
+
+		/* skip empty lines */
+		while(c == '\r' || c == '\n') {
+			c = input.get();
+		}
+		if(c < 0) {
+			return false;
+		}
+
+		for(;;) {
+			bool quoted = (c == '"');
+
+			target.beginValue(SQLITE_TEXT);
+			if(quoted) {
+				for(;;) {
+					c = input.get();
+					if(c < 0) {
+				        throw esl::system::Stacktrace::add(std::runtime_error("Unterminated quoted value in CSV import"));
+					}
+					if(c == '"') {
+						c = input.get();
+						if(c != '"') {
+							break;
+						}
+					}
+					target.appendValue(static_cast<char>(c));
+				}
+			}
+			else {
+				while(c >= 0 && c != delimiter && c != '\n' && c != '\r') {
+					target.appendValue(static_cast<char>(c));
+					c = input.get();
+				}
+			}
+			target.endValue(!quoted);
+
+			if(c == delimiter) {
+				c = input.get();
+				continue;
+			}
+
+			if(c == '\r') {
+				c = input.get();
+				if(c >= 0 && c != '\n') {
+					input.unget();
+				}
+			}
+			else if(c >= 0 && c != '\n') {
+		        throw esl::system::Stacktrace::add(std::runtime_error("Invalid character after quoted value in CSV import"));
+			}
+
+			target.endRow();
+			return true;
+		}
+	}
+
+	FileInput input;
+	char delimiter;
+	bool header;
+};
+
+class BinaryReader {
+public:
+	BinaryReader(int fileDescriptor)
+	: input(fileDescriptor)
+	{ }
+
+	bool read(Importer::Batch& batch) {
+		if(!headerRead) {
+			headerRead = true;
+			readHeader(batch);
+		}
+
+		while(!batch.isFull()) {
+			char marker;
+			input.read(&marker, 1);
+			if(marker == 0) {
+				return false;
+			}
+
+			for(std::size_t i = 0; i < columnCount; ++i) {
+				char type;
+				input.read(&type, 1);
+
+				switch(type) {
+				case SQLITE_INTEGER:
+					batch.addInteger(static_cast<std::int64_t>(input.readUInt(8)));
+					break;
+				case SQLITE_FLOAT: {
+					std::uint64_t bits = input.readUInt(8);
+					double value;
+					std::memcpy(&value, &bits, sizeof(value));
+					batch.addDouble(value);
+					break;
+				}
+				case SQLITE_TEXT:
+				case SQLITE_BLOB: {
+					std::size_t size = static_cast<std::size_t>(input.readUInt(4));
+					batch.beginValue(type);
+					for(std::size_t j = 0; j < size; ++j) {
+						int c = input.get();
+						if(c < 0) {
+					        throw esl::system::Stacktrace::add(std::runtime_error("Unexpected end of import input"));
+						}
+						batch.appendValue(static_cast<char>(c));
+					}
+					batch.endValue(false);
+					break;
+				}
+				case SQLITE_NULL:
+					batch.addNull();
+					break;
+				default:
+			        throw esl::system::Stacktrace::add(std::runtime_error("Invalid value type " + std::to_string(static_cast<int>(type)) + " in binary import"));
+				}
+			}
+			batch.endRow();
+		}
+		return true;
+	}
+
+private:
+	void readHeader(Importer::Batch& batch) {
+		char magic[5];
+		input.read(magic, sizeof(magic));
+		if(std::memcmp(magic, "S4EB", 4) != 0 || magic[4] != 1) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Import input is not in binary row format version 1"));
+		}
+
+		columnCount = static_cast<std::size_t>(input.readUInt(4));
+		std::vector<std::string> columnNames;
+		for(std::size_t i = 0; i < columnCount; ++i) {
+			std::string name(static_cast<std::size_t>(input.readUInt(4)), '\0');
+			input.read(&name[0], name.size());
+			columnNames.push_back(std::move(name));
+		}
+		batch.setColumnNames(std::move(columnNames));
+	}
+
+	FileInput input;
+	bool headerRead = false;
+	std::size_t columnCount = 0;
+};
+}
+
+Importer::Batch::Batch(std::size_t aCapacity)
+: capacity(aCapacity == 0 ? 1 : aCapacity)
+{ }
+
+void Importer::Batch::setColumnNames(std::vector<std::string> aColumnNames) {
+	columnNames = std::move(aColumnNames);
+}
+
+const std::vector<std::string>& Importer::Batch::getColumnNames() const noexcept {
+	return columnNames;
+}
+
+std::size_t Importer::Batch::getColumnCount() const noexcept {
+	return columnCount;
+}
+
+std::size_t Importer::Batch::getRowCount() const noexcept {
+	return rowCount;
+}
+
+bool Importer::Batch::isFull() const noexcept {
+	return rowCount >= capacity;
+}
+
+void Importer::Batch::clear() noexcept {
+	columnCount = 0;
+	rowCount = 0;
+	rowBegin = 0;
+	cells.clear();
+	data.clear();
+	columnNames.clear();
+}
+
+void Importer::Batch::addNull() {
+	cells.push_back(Cell{SQLITE_NULL, 0, 0.0, 0, 0});
+}
+
+void Importer::Batch::addInteger(std::int64_t value) {
+	cells.push_back(Cell{SQLITE_INTEGER, value, 0.0, 0, 0});
+}
+
+void Importer::Batch::addDouble(double value) {
+	cells.push_back(Cell{SQLITE_FLOAT, 0, value, 0, 0});
+}
+
+void Importer::Batch::addText(const char* value, std::size_t size) {
+	cells.push_back(Cell{SQLITE_TEXT, 0, 0.0, data.size(), size});
+	data.append(value, size);
+}
+
+void Importer::Batch::addBlob(const void* value, std::size_t size) {
+	cells.push_back(Cell{SQLITE_BLOB, 0, 0.0, data.size(), size});
+	data.append(static_cast<const char*>(value), size);
+}
+
+void Importer::Batch::beginValue(int type) {
+	cells.push_back(Cell{type, 0, 0.0, data.size(), 0});
+}
+
+void Importer::Batch::endValue(bool nullIfEmpty) {
+	Cell& cell = cells.back();
+	cell.size = data.size() - cell.offset;
+	if(nullIfEmpty && cell.size == 0) {
+		cell.type = SQLITE_NULL;
+	}
+}
+
+void Importer::Batch::endRow() {
+	std::size_t rowSize = cells.size() - rowBegin;
+	if(rowCount == 0) {
+		columnCount = rowSize;
+	}
+	else if(rowSize != columnCount) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Import row has " + std::to_string(rowSize) + " values, but " + std::to_string(columnCount) + " values are expected"));
+	}
+
+	rowBegin = cells.size();
+	++rowCount;
+}
+
+double Importer::Statistics::getRowsPerSecond() const noexcept {
+	if(duration.count() <= 0) {
+		return 0.0;
+	}
+	return static_cast<double>(rows) * 1000000.0 / static_cast<double>(duration.count());
+}
+
+Importer::Importer(const Connection& aConnection, std::string aTableName)
+: connection(aConnection),
+  tableName(std::move(aTableName))
+{ }
+
+Importer& Importer::setColumns(std::vector<std::string> aColumns) {
+	columns = std::move(aColumns);
+	return *this;
+}
+
+Importer& Importer::setBatchRows(std::size_t aBatchRows) noexcept {
+	batchRows = aBatchRows;
+	return *this;
+}
+
+Importer& Importer::setTransactionRows(std::size_t aTransactionRows) noexcept {
+	transactionRows = aTransactionRows;
+	return *this;
+}
+
+Importer& Importer::setDropIndexes(bool aDropIndexes) noexcept {
+	dropIndexesEnabled = aDropIndexes;
+	return *this;
+}
+
+Importer::Statistics Importer::import(Reader reader) const {
+	if(sqlite3_get_autocommit(const_cast<sqlite3*>(&connection.getConnectionHandle())) == 0) {
+		/* the import commits every "transactionRows" rows and rolls back on failure */
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot import into table \"" + tableName + "\" within an open transaction"));
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Statistics statistics;
+
+	std::vector<Batch> batches;
+	batches.reserve(2);
+	batches.emplace_back(batchRows);
+	batches.emplace_back(batchRows);
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<Batch*> freeBatches = { &batches[0], &batches[1] };
+	std::deque<Batch*> filledBatches;
+	bool readerDone = false;
+	bool writerStopped = false;
+	std::exception_ptr readerError;
+
+	/* parses into free batches while the calling thread writes the filled ones */
+	std::thread readerThread([&]() {
+		try {
+			bool more = true;
+			while(more) {
+				Batch* batch;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					condition.wait(lock, [&] { return !freeBatches.empty() || writerStopped; });
+					if(writerStopped) {
+						return;
+					}
+					batch = freeBatches.back();
+					freeBatches.pop_back();
+				}
+
+				batch->clear();
+				more = reader(*batch);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if(batch->getRowCount() > 0 || !batch->getColumnNames().empty()) {
+						filledBatches.push_back(batch);
+					}
+					else {
+						freeBatches.push_back(batch);
+					}
+					readerDone = !more;
+				}
+				condition.notify_all();
+			}
+		}
+		catch(...) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				readerError = std::current_exception();
+				readerDone = true;
+			}
+			condition.notify_all();
+		}
+	});
+
+	sqlite3& connectionHandle = const_cast<sqlite3&>(connection.getConnectionHandle());
+	std::vector<Index> indexes;
+
+	try {
+		StatementHandle statementHandle;
+		std::size_t transactionRowCount = 0;
+
+		if(dropIndexesEnabled) {
+			indexes = dropIndexes();
+		}
+
+		for(;;) {
+			Batch* batch;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [&] { return !filledBatches.empty() || readerDone; });
+				if(filledBatches.empty()) {
+					if(readerError) {
+						std::rethrow_exception(readerError);
+					}
+					break;
+				}
+				batch = filledBatches.front();
+				filledBatches.pop_front();
+			}
+
+			if(!statementHandle) {
+				statementHandle = connection.prepareSQLite(getInsertStatement(*batch));
+			}
+
+			if(batch->getRowCount() > 0) {
+				if(sqlite3_get_autocommit(&connectionHandle) != 0) {
+					execute(connection, "BEGIN IMMEDIATE;");
+					++statistics.transactions;
+				}
+
+				write(statementHandle, *batch);
+				statistics.rows += batch->getRowCount();
+				transactionRowCount += batch->getRowCount();
+				++statistics.batches;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				freeBatches.push_back(batch);
+			}
+			condition.notify_all();
+
+			if(transactionRowCount >= transactionRows) {
+				execute(connection, "COMMIT;");
+				transactionRowCount = 0;
+			}
+		}
+
+		if(sqlite3_get_autocommit(&connectionHandle) == 0) {
+			execute(connection, "COMMIT;");
+		}
+	}
+	catch(...) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			writerStopped = true;
+		}
+		condition.notify_all();
+		readerThread.join();
+
+		if(sqlite3_get_autocommit(&connectionHandle) == 0) {
+			sqlite3_exec(&connectionHandle, "ROLLBACK;", nullptr, nullptr, nullptr);
+		}
+		if(!indexes.empty()) {
+			try {
+				createIndexes(indexes);
+			}
+			catch(const std::exception& e) {
+				logger.error << "Cannot create dropped indexes of table \"" << tableName << "\" again: " << e.what() << "\n";
+			}
+		}
+		throw;
+	}
+	readerThread.join();
+
+	if(!indexes.empty()) {
+		createIndexes(indexes);
+	}
+
+	statistics.duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	return statistics;
+}
+
+Importer::Reader Importer::csvReader(int fileDescriptor, char delimiter, bool header) {
+	std::shared_ptr<CsvReader> csvReader(new CsvReader(fileDescriptor, delimiter, header));
+	return [csvReader](Batch& batch) {
+		return csvReader->read(batch);
+	};
+}
+
+Importer::Reader Importer::binaryReader(int fileDescriptor) {
+	std::shared_ptr<BinaryReader> binaryReader(new BinaryReader(fileDescriptor));
+	return [binaryReader](Batch& batch) {
+		return binaryReader->read(batch);
+	};
+}
+
+std::vector<Importer::Index> Importer::dropIndexes() const {
+	std::vector<Index> indexes;
+
+	/* indexes of UNIQUE and PRIMARY KEY constraints have no SQL and are kept */
+	StatementHandle statementHandle = connection.prepareSQLite("SELECT name, sql FROM sqlite_master WHERE type = 'index' AND tbl_name = ? AND sql IS NOT NULL;");
+	statementHandle.bindText(0, tableName);
+	while(statementHandle.step()) {
+		Index index;
+		index.name = statementHandle.columnText(0);
+		index.sql = statementHandle.columnText(1);
+		indexes.push_back(std::move(index));
+	}
+	statementHandle.reset();
+
+	if(!indexes.empty()) {
+		execute(connection, "BEGIN IMMEDIATE;");
+		try {
+			for(const auto& index : indexes) {
+				execute(connection, "DROP INDEX " + quoteIdentifier(index.name) + ";");
+			}
+			execute(connection, "COMMIT;");
+		}
+		catch(...) {
+			sqlite3_exec(&const_cast<sqlite3&>(connection.getConnectionHandle()), "ROLLBACK;", nullptr, nullptr, nullptr);
+			throw;
+		}
+	}
+
+	return indexes;
+}
+
+void Importer::createIndexes(const std::vector<Index>& indexes) const {
+	execute(connection, "BEGIN IMMEDIATE;");
+	try {
+		for(const auto& index : indexes) {
+			execute(connection, index.sql + ";");
+		}
+		execute(connection, "COMMIT;");
+	}
+	catch(...) {
+		sqlite3_exec(&const_cast<sqlite3&>(connection.getConnectionHandle()), "ROLLBACK;", nullptr, nullptr, nullptr);
+		throw;
+	}
+}
+
+std::string Importer::getInsertStatement(const Batch& batch) const {
+	const std::vector<std::string>& columnNames = columns.empty() ? batch.getColumnNames() : columns;
+	std::size_t columnCount = columnNames.empty() ? batch.getColumnCount() : columnNames.size();
+
+	if(columnCount == 0) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot import into table \"" + tableName + "\" without columns"));
+	}
+
+	std::string sql = "INSERT INTO " + quoteIdentifier(tableName);
+	if(!columnNames.empty()) {
+		sql += " (";
+		for(std::size_t i = 0; i < columnNames.size(); ++i) {
+			if(i > 0) {
+				sql += ", ";
+			}
+			sql += quoteIdentifier(columnNames[i]);
+		}
+		sql += ")";
+	}
+
+	sql += " VALUES (?";
+	for(std::size_t i = 1; i < columnCount; ++i) {
+		sql += ", ?";
+	}
+	return sql + ");";
+}
+
+void Importer::write(const StatementHandle& statementHandle, const Batch& batch) const {
+	sqlite3_stmt& statement = statementHandle.getHandle();
+	std::size_t columnCount = batch.getColumnCount();
+
+	if(columnCount != static_cast<std::size_t>(sqlite3_bind_parameter_count(&statement))) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Import rows have " + std::to_string(columnCount) + " values, but table \"" + tableName + "\" expects " + std::to_string(sqlite3_bind_parameter_count(&statement))));
+	}
+
+	/* text and blobs stay valid until the batch is returned to the reader */
+	const Batch::Cell* cell = batch.cells.data();
+	for(std::size_t row = 0; row < batch.getRowCount(); ++row) {
+		for(std::size_t column = 0; column < columnCount; ++column, ++cell) {
+			int index = static_cast<int>(column) + 1;
+			int rc;
+
+			switch(cell->type) {
+			case SQLITE_INTEGER:
+				rc = sqlite3_bind_int64(&statement, index, cell->integer);
+				break;
+			case SQLITE_FLOAT:
+				rc = sqlite3_bind_double(&statement, index, cell->real);
+				break;
+			case SQLITE_TEXT:
+				rc = sqlite3_bind_text(&statement, index, batch.data.data() + cell->offset, static_cast<int>(cell->size), SQLITE_STATIC);
+				break;
+			case SQLITE_BLOB:
+				rc = sqlite3_bind_blob(&statement, index, batch.data.data() + cell->offset, static_cast<int>(cell->size), SQLITE_STATIC);
+				break;
+			default:
+				rc = sqlite3_bind_null(&statement, index);
+				break;
+			}
+
+			if(rc != SQLITE_OK) {
+		        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot bind import value", rc, sqlite3_db_handle(&statement)));
+			}
+		}
+
+		statementHandle.step();
+		statementHandle.reset();
+	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings, batch.cells.size());
+	ExecutionStatistics::add(ExecutionStatistics::bytesBound, batch.data.size());
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,149 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_IMPORTER_H_
+#define SQLITE4ESL_DATABASE_IMPORTER_H_
+
+#include <sqlite4esl/database/Connection.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Loads rows into a table. A reader parses the input on a separate thread into one
+ * of two batches while the calling thread binds and steps the other batch with a
+ * single prepared INSERT. Commits are grouped into large transactions.
+ *
+ *   Importer importer(connection, "measurement");
+ *   importer.setTransactionRows(1000000).setDropIndexes(true);
+ *   Importer::Statistics statistics = importer.import(Importer::csvReader(fd));
+ *
+ * Transactions committed before a failure are not rolled back. The connection must not
+ * have an open transaction, because the importer commits its own transactions. */
+class Importer {
+public:
+	/* Rows of parsed values. Text and blobs are copied into one buffer per batch
+	 * that is reused for the next rows, so filling a batch does not allocate per cell. */
+	class Batch {
+	public:
+		Batch(std::size_t capacity);
+
+		/* Optional, used as column list of the INSERT if no columns are set at the importer */
+		void setColumnNames(std::vector<std::string> columnNames);
+		const std::vector<std::string>& getColumnNames() const noexcept;
+
+		std::size_t getColumnCount() const noexcept;
+		std::size_t getRowCount() const noexcept;
+		bool isFull() const noexcept;
+		void clear() noexcept;
+
+		void addNull();
+		void addInteger(std::int64_t value);
+		void addDouble(double value);
+		void addText(const char* data, std::size_t size);
+		void addBlob(const void* data, std::size_t size);
+
+		/* Builds a text or blob value incrementally */
+		void beginValue(int type);
+		void appendValue(char c) {
+			data.push_back(c);
+		}
+		void endValue(bool nullIfEmpty);
+
+		/* All rows must have the same number of values as the first row */
+		void endRow();
+
+	private:
+		friend class Importer;
+
+		struct Cell {
+			int type;
+			std::int64_t integer;
+			double real;
+			std::size_t offset;
+			std::size_t size;
+		};
+
+		std::size_t capacity;
+		std::size_t columnCount = 0;
+		std::size_t rowCount = 0;
+		std::size_t rowBegin = 0;
+		std::vector<Cell> cells;
+		std::string data;
+		std::vector<std::string> columnNames;
+	};
+
+	/* Fills the batch until it is full and returns false once the input is exhausted */
+	using Reader = std::function<bool(Batch&)>;
+
+	struct Statistics {
+		std::uint64_t rows = 0;
+		std::uint64_t batches = 0;
+		std::uint64_t transactions = 0;
+		std::chrono::microseconds duration = std::chrono::microseconds(0);
+
+		double getRowsPerSecond() const noexcept;
+	};
+
+	Importer(const Connection& connection, std::string tableName);
+
+	Importer& setColumns(std::vector<std::string> columns);
+	Importer& setBatchRows(std::size_t batchRows) noexcept;
+	Importer& setTransactionRows(std::size_t transactionRows) noexcept;
+	/* Drops the indexes of the table before the load and creates them again afterwards */
+	Importer& setDropIndexes(bool dropIndexes) noexcept;
+
+	Statistics import(Reader reader) const;
+
+	/* CSV (RFC 4180) from a file descriptor. Values are bound as text, empty unquoted
+	 * values as NULL. With "header" the first line provides the column names. */
+	static Reader csvReader(int fileDescriptor, char delimiter = ',', bool header = true);
+	/* Binary row format written by Exporter */
+	static Reader binaryReader(int fileDescriptor);
+
+private:
+	struct Index {
+		std::string name;
+		std::string sql;
+	};
+
+	std::vector<Index> dropIndexes() const;
+	void createIndexes(const std::vector<Index>& indexes) const;
+	std::string getInsertStatement(const Batch& batch) const;
+	void write(const StatementHandle& statementHandle, const Batch& batch) const;
+
+	const Connection& connection;
+	std::string tableName;
+	std::vector<std::string> columns;
+	std::size_t batchRows = 10000;
+	std::size_t transactionRows = 500000;
+	bool dropIndexesEnabled = false;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_IMPORTER_H_ */
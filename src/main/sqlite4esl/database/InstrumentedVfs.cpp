@@ -0,0 +1,434 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/InstrumentedVfs.h>
+
+#include <esl/Logger.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::InstrumentedVfs");
+
+struct OperationCounters {
+	std::atomic<std::uint64_t> count{0};
+	std::atomic<std::uint64_t> bytes{0};
+	std::atomic<std::uint64_t> nanoseconds{0};
+	std::array<std::atomic<std::uint64_t>, 32> latencyHistogram{};
+
+	void add(std::uint64_t addBytes, std::chrono::steady_clock::time_point startTime) {
+		std::uint64_t duration = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+
+		std::size_t bucket = 0;
+		for(std::uint64_t value = duration >> 1; value > 0 && bucket + 1 < latencyHistogram.size(); value >>= 1) {
+			++bucket;
+		}
+
+		count.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(addBytes, std::memory_order_relaxed);
+		nanoseconds.fetch_add(duration, std::memory_order_relaxed);
+		latencyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	IoStatistics::Operation get() const {
+		IoStatistics::Operation operation;
+		operation.count = count.load(std::memory_order_relaxed);
+		operation.bytes = bytes.load(std::memory_order_relaxed);
+		operation.duration = std::chrono::nanoseconds(nanoseconds.load(std::memory_order_relaxed));
+		for(std::size_t i=0; i<latencyHistogram.size(); ++i) {
+			operation.latencyHistogram[i] = latencyHistogram[i].load(std::memory_order_relaxed);
+		}
+		return operation;
+	}
+};
+
+struct FileCounters {
+	OperationCounters reads;
+	OperationCounters writes;
+	OperationCounters syncs;
+};
+
+struct Shim {
+	sqlite3_vfs vfs;
+	sqlite3_vfs* baseVfs;
+	std::string name;
+};
+
+/* The shim file is followed by the file of the base VFS */
+struct ShimFile {
+	sqlite3_file base;
+	FileCounters* fileCounters;
+	sqlite3_file* realFile;
+};
+
+std::mutex shimsMutex;
+/* shims and counters live until the process terminates, because sqlite3 keeps pointers */
+std::map<std::string, std::unique_ptr<Shim>> shims;
+std::map<std::string, std::unique_ptr<FileCounters>> fileCounters;
+
+FileCounters& getFileCounters(const char* name) {
+	std::lock_guard<std::mutex> lock(shimsMutex);
+	std::unique_ptr<FileCounters>& counters = fileCounters[name ? name : ""];
+	if(!counters) {
+		counters.reset(new FileCounters);
+	}
+	return *counters;
+}
+
+sqlite3_file& getRealFile(sqlite3_file* file) {
+	return *reinterpret_cast<ShimFile*>(file)->realFile;
+}
+
+sqlite3_vfs& getBaseVfs(sqlite3_vfs* vfs) {
+	return *static_cast<Shim*>(vfs->pAppData)->baseVfs;
+}
+
+int shimClose(sqlite3_file* file) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xClose(&realFile);
+}
+
+int shimRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset) {
+	sqlite3_file& realFile = getRealFile(file);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	int rc = realFile.pMethods->xRead(&realFile, buffer, amount, offset);
+	reinterpret_cast<ShimFile*>(file)->fileCounters->reads.add(static_cast<std::uint64_t>(amount), startTime);
+	return rc;
+}
+
+int shimWrite(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset) {
+	sqlite3_file& realFile = getRealFile(file);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	int rc = realFile.pMethods->xWrite(&realFile, buffer, amount, offset);
+	reinterpret_cast<ShimFile*>(file)->fileCounters->writes.add(static_cast<std::uint64_t>(amount), startTime);
+	return rc;
+}
+
+int shimTruncate(sqlite3_file* file, sqlite3_int64 size) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xTruncate(&realFile, size);
+}
+
+int shimSync(sqlite3_file* file, int flags) {
+	sqlite3_file& realFile = getRealFile(file);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	int rc = realFile.pMethods->xSync(&realFile, flags);
+	reinterpret_cast<ShimFile*>(file)->fileCounters->syncs.add(0, startTime);
+	return rc;
+}
+
+int shimFileSize(sqlite3_file* file, sqlite3_int64* size) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xFileSize(&realFile, size);
+}
+
+int shimLock(sqlite3_file* file, int lock) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xLock(&realFile, lock);
+}
+
+int shimUnlock(sqlite3_file* file, int lock) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xUnlock(&realFile, lock);
+}
+
+int shimCheckReservedLock(sqlite3_file* file, int* result) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xCheckReservedLock(&realFile, result);
+}
+
+int shimFileControl(sqlite3_file* file, int operation, void* argument) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xFileControl(&realFile, operation, argument);
+}
+
+int shimSectorSize(sqlite3_file* file) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xSectorSize(&realFile);
+}
+
+int shimDeviceCharacteristics(sqlite3_file* file) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xDeviceCharacteristics(&realFile);
+}
+
+int shimShmMap(sqlite3_file* file, int region, int size, int extend, void volatile** memory) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xShmMap(&realFile, region, size, extend, memory);
+}
+
+int shimShmLock(sqlite3_file* file, int offset, int n, int flags) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xShmLock(&realFile, offset, n, flags);
+}
+
+void shimShmBarrier(sqlite3_file* file) {
+	sqlite3_file& realFile = getRealFile(file);
+	realFile.pMethods->xShmBarrier(&realFile);
+}
+
+int shimShmUnmap(sqlite3_file* file, int deleteFlag) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xShmUnmap(&realFile, deleteFlag);
+}
+
+int shimFetch(sqlite3_file* file, sqlite3_int64 offset, int amount, void** pointer) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xFetch(&realFile, offset, amount, pointer);
+}
+
+int shimUnfetch(sqlite3_file* file, sqlite3_int64 offset, void* pointer) {
+	sqlite3_file& realFile = getRealFile(file);
+	return realFile.pMethods->xUnfetch(&realFile, offset, pointer);
+}
+
+/* One method table per version of the io methods of the base VFS */
+sqlite3_io_methods makeIoMethods(int version) {
+	sqlite3_io_methods ioMethods = {
+		version,
+		shimClose,
+		shimRead,
+		shimWrite,
+		shimTruncate,
+		shimSync,
+		shimFileSize,
+		shimLock,
+		shimUnlock,
+		shimCheckReservedLock,
+		shimFileControl,
+		shimSectorSize,
+		shimDeviceCharacteristics,
+		version >= 2 ? shimShmMap : nullptr,
+		version >= 2 ? shimShmLock : nullptr,
+		version >= 2 ? shimShmBarrier : nullptr,
+		version >= 2 ? shimShmUnmap : nullptr,
+		version >= 3 ? shimFetch : nullptr,
+		version >= 3 ? shimUnfetch : nullptr
+	};
+	return ioMethods;
+}
+
+const sqlite3_io_methods ioMethods[] = {
+	makeIoMethods(1),
+	makeIoMethods(2),
+	makeIoMethods(3)
+};
+
+int shimOpen(sqlite3_vfs* vfs, const char* name, sqlite3_file* file, int flags, int* outFlags) {
+	ShimFile& shimFile = *reinterpret_cast<ShimFile*>(file);
+	shimFile.realFile = reinterpret_cast<sqlite3_file*>(&shimFile + 1);
+	shimFile.fileCounters = &getFileCounters(name);
+
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	int rc = baseVfs.xOpen(&baseVfs, name, shimFile.realFile, flags, outFlags);
+
+	/* xClose is called only if pMethods is set */
+	const sqlite3_io_methods* realIoMethods = shimFile.realFile->pMethods;
+	if(realIoMethods == nullptr) {
+		shimFile.base.pMethods = nullptr;
+	}
+	else {
+		int version = realIoMethods->iVersion < 1 ? 1 : (realIoMethods->iVersion > 3 ? 3 : realIoMethods->iVersion);
+		shimFile.base.pMethods = &ioMethods[version - 1];
+	}
+
+	return rc;
+}
+
+int shimDelete(sqlite3_vfs* vfs, const char* name, int syncDir) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xDelete(&baseVfs, name, syncDir);
+}
+
+int shimAccess(sqlite3_vfs* vfs, const char* name, int flags, int* result) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xAccess(&baseVfs, name, flags, result);
+}
+
+int shimFullPathname(sqlite3_vfs* vfs, const char* name, int size, char* output) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xFullPathname(&baseVfs, name, size, output);
+}
+
+void* shimDlOpen(sqlite3_vfs* vfs, const char* fileName) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xDlOpen(&baseVfs, fileName);
+}
+
+void shimDlError(sqlite3_vfs* vfs, int size, char* message) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	baseVfs.xDlError(&baseVfs, size, message);
+}
+
+void (*shimDlSym(sqlite3_vfs* vfs, void* handle, const char* symbol))(void) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xDlSym(&baseVfs, handle, symbol);
+}
+
+void shimDlClose(sqlite3_vfs* vfs, void* handle) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	baseVfs.xDlClose(&baseVfs, handle);
+}
+
+int shimRandomness(sqlite3_vfs* vfs, int size, char* output) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xRandomness(&baseVfs, size, output);
+}
+
+int shimSleep(sqlite3_vfs* vfs, int microseconds) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xSleep(&baseVfs, microseconds);
+}
+
+int shimCurrentTime(sqlite3_vfs* vfs, double* time) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xCurrentTime(&baseVfs, time);
+}
+
+int shimGetLastError(sqlite3_vfs* vfs, int size, char* message) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xGetLastError ? baseVfs.xGetLastError(&baseVfs, size, message) : 0;
+}
+
+int shimCurrentTimeInt64(sqlite3_vfs* vfs, sqlite3_int64* time) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xCurrentTimeInt64(&baseVfs, time);
+}
+
+int shimSetSystemCall(sqlite3_vfs* vfs, const char* name, sqlite3_syscall_ptr systemCall) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xSetSystemCall(&baseVfs, name, systemCall);
+}
+
+sqlite3_syscall_ptr shimGetSystemCall(sqlite3_vfs* vfs, const char* name) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xGetSystemCall(&baseVfs, name);
+}
+
+const char* shimNextSystemCall(sqlite3_vfs* vfs, const char* name) {
+	sqlite3_vfs& baseVfs = getBaseVfs(vfs);
+	return baseVfs.xNextSystemCall(&baseVfs, name);
+}
+}
+
+IoStatistics::Operation& IoStatistics::Operation::operator+=(const Operation& operation) {
+	count += operation.count;
+	bytes += operation.bytes;
+	duration += operation.duration;
+	for(std::size_t i=0; i<latencyHistogram.size(); ++i) {
+		latencyHistogram[i] += operation.latencyHistogram[i];
+	}
+	return *this;
+}
+
+IoStatistics& IoStatistics::operator+=(const IoStatistics& ioStatistics) {
+	reads += ioStatistics.reads;
+	writes += ioStatistics.writes;
+	syncs += ioStatistics.syncs;
+	return *this;
+}
+
+std::string InstrumentedVfs::install(const std::string& baseVfsName) {
+	sqlite3_vfs* baseVfs = sqlite3_vfs_find(baseVfsName.empty() ? nullptr : baseVfsName.c_str());
+	if(baseVfs == nullptr) {
+        throw esl::system::Stacktrace::add(std::runtime_error("VFS \"" + baseVfsName + "\" is not registered"));
+	}
+
+	std::lock_guard<std::mutex> lock(shimsMutex);
+
+	std::unique_ptr<Shim>& shim = shims[baseVfs->zName];
+	if(shim) {
+		return shim->name;
+	}
+
+	shim.reset(new Shim);
+	shim->baseVfs = baseVfs;
+	shim->name = std::string("sqlite4esl-instrumented-") + baseVfs->zName;
+
+	sqlite3_vfs& vfs = shim->vfs;
+	vfs = sqlite3_vfs();
+	vfs.iVersion = baseVfs->iVersion < 3 ? baseVfs->iVersion : 3;
+	vfs.szOsFile = static_cast<int>(sizeof(ShimFile)) + baseVfs->szOsFile;
+	vfs.mxPathname = baseVfs->mxPathname;
+	vfs.zName = shim->name.c_str();
+	vfs.pAppData = shim.get();
+	vfs.xOpen = shimOpen;
+	vfs.xDelete = shimDelete;
+	vfs.xAccess = shimAccess;
+	vfs.xFullPathname = shimFullPathname;
+	vfs.xDlOpen = baseVfs->xDlOpen ? shimDlOpen : nullptr;
+	vfs.xDlError = baseVfs->xDlError ? shimDlError : nullptr;
+	vfs.xDlSym = baseVfs->xDlSym ? shimDlSym : nullptr;
+	vfs.xDlClose = baseVfs->xDlClose ? shimDlClose : nullptr;
+	vfs.xRandomness = shimRandomness;
+	vfs.xSleep = shimSleep;
+	vfs.xCurrentTime = shimCurrentTime;
+	vfs.xGetLastError = shimGetLastError;
+	if(vfs.iVersion >= 2) {
+		vfs.xCurrentTimeInt64 = baseVfs->xCurrentTimeInt64 ? shimCurrentTimeInt64 : nullptr;
+	}
+	if(vfs.iVersion >= 3) {
+		vfs.xSetSystemCall = baseVfs->xSetSystemCall ? shimSetSystemCall : nullptr;
+		vfs.xGetSystemCall = baseVfs->xGetSystemCall ? shimGetSystemCall : nullptr;
+		vfs.xNextSystemCall = baseVfs->xNextSystemCall ? shimNextSystemCall : nullptr;
+	}
+
+	int rc = sqlite3_vfs_register(&vfs, 0);
+	if(rc != SQLITE_OK) {
+		std::string name = shim->name;
+		shims.erase(baseVfs->zName);
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot register VFS \"" + name + "\": " + sqlite3_errstr(rc)));
+	}
+
+	logger.debug << "Registered VFS \"" << shim->name << "\"\n";
+	return shim->name;
+}
+
+std::map<std::string, IoStatistics> InstrumentedVfs::getStatistics() {
+	return getStatistics("");
+}
+
+std::map<std::string, IoStatistics> InstrumentedVfs::getStatistics(const std::string& path) {
+	std::map<std::string, IoStatistics> statistics;
+
+	std::lock_guard<std::mutex> lock(shimsMutex);
+	for(const auto& counters : fileCounters) {
+		if(counters.first.compare(0, path.size(), path) != 0) {
+			continue;
+		}
+
+		IoStatistics& ioStatistics = statistics[counters.first];
+		ioStatistics.reads = counters.second->reads.get();
+		ioStatistics.writes = counters.second->writes.get();
+		ioStatistics.syncs = counters.second->syncs.get();
+	}
+	return statistics;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,76 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_INSTRUMENTEDVFS_H_
+#define SQLITE4ESL_DATABASE_INSTRUMENTEDVFS_H_
+
+#include <sqlite3.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+struct IoStatistics {
+	struct Operation {
+		std::uint64_t count = 0;
+		std::uint64_t bytes = 0;
+		std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);
+		/* bucket i counts operations that took less than 2^(i+1) nanoseconds, the last
+		 * bucket everything longer */
+		std::array<std::uint64_t, 32> latencyHistogram{};
+
+		Operation& operator+=(const Operation& operation);
+	};
+
+	Operation reads;
+	Operation writes;
+	Operation syncs;
+
+	IoStatistics& operator+=(const IoStatistics& ioStatistics);
+};
+
+/* Shim VFS that forwards every call to a base VFS and records counts, bytes and
+ * latencies of reads, writes and syncs per file. VFS are registered for the whole
+ * process, so there is one shim per base VFS and it is never unregistered. Pages read
+ * through memory mapping (mmapSize) are not seen by the shim. It is also the place for
+ * experimental backends that replace single methods of the base VFS. */
+class InstrumentedVfs {
+public:
+	/* Registers the shim for "baseVfs" (the default VFS if empty) and returns its name */
+	static std::string install(const std::string& baseVfs);
+
+	/* Statistics of all files opened by any shim, keyed by the full path, temporary
+	 * files are summed up as "" */
+	static std::map<std::string, IoStatistics> getStatistics();
+	/* Statistics of files whose path starts with "path", e.g. a database with its
+	 * journal and WAL file */
+	static std::map<std::string, IoStatistics> getStatistics(const std::string& path);
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_INSTRUMENTEDVFS_H_ */
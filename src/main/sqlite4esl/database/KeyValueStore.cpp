@@ -0,0 +1,192 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/KeyValueStore.h>
+#include <sqlite4esl/database/Connection.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+const std::size_t maxMultiGetKeys = 256;
+
+std::string quoteIdentifier(const std::string& identifier) {
+	std::string result = "\"";
+	for(char c : identifier) {
+		if(c == '"') {
+			result += '"';
+		}
+		result += c;
+	}
+	return result + "\"";
+}
+
+void assign(const StatementHandle& statementHandle, int index, std::string& value) {
+	sqlite3_stmt& stmt = statementHandle.getHandle();
+	const char* data = static_cast<const char*>(sqlite3_column_blob(&stmt, index));
+	value.assign(data ? data : "", static_cast<std::size_t>(sqlite3_column_bytes(&stmt, index)));
+}
+}
+
+KeyValueStore::KeyValueStore(const Connection& aConnection, const std::string& aTable)
+: connection(aConnection),
+  table(quoteIdentifier(aTable))
+{
+	connection.prepareSQLite("CREATE TABLE IF NOT EXISTS " + table + "(key BLOB PRIMARY KEY, value BLOB) WITHOUT ROWID;").step();
+
+	getStatement = prepare("SELECT value FROM " + table + " WHERE key = ?;");
+	/* upsert updates the row in place, REPLACE would delete and insert it */
+	putStatement = prepare("INSERT INTO " + table + "(key, value) VALUES(?, ?) ON CONFLICT(key) DO UPDATE SET value = excluded.value;");
+	removeStatement = prepare("DELETE FROM " + table + " WHERE key = ?;");
+}
+
+bool KeyValueStore::get(const std::string& key, std::string& value) {
+	bool found;
+	try {
+		getStatement.bindBlob(0, key.data(), key.size());
+		found = getStatement.step();
+		if(found) {
+			assign(getStatement, 0, value);
+		}
+	}
+	catch(...) {
+		sqlite3_reset(&getStatement.getHandle());
+		throw;
+	}
+	getStatement.reset();
+
+	return found;
+}
+
+std::map<std::string, std::string> KeyValueStore::get(const std::vector<std::string>& keys) {
+	std::map<std::string, std::string> result;
+
+	for(std::size_t offset = 0; offset < keys.size(); offset += maxMultiGetKeys) {
+		std::size_t count = std::min(keys.size() - offset, maxMultiGetKeys);
+		const StatementHandle& statementHandle = getMultiGetStatement(count);
+
+		try {
+			/* unused parameters repeat the last key */
+			std::size_t parameters = statementHandle.bindParameterCount();
+			for(std::size_t i = 0; i < parameters; ++i) {
+				const std::string& key = keys[offset + std::min(i, count - 1)];
+				statementHandle.bindBlob(i, key.data(), key.size());
+			}
+
+			std::string key;
+			while(statementHandle.step()) {
+				assign(statementHandle, 0, key);
+				assign(statementHandle, 1, result[key]);
+			}
+		}
+		catch(...) {
+			sqlite3_reset(&statementHandle.getHandle());
+			throw;
+		}
+		statementHandle.reset();
+	}
+
+	return result;
+}
+
+void KeyValueStore::put(const std::string& key, const std::string& value) {
+	putStatement.bindBlob(0, key.data(), key.size());
+	putStatement.bindBlob(1, value.data(), value.size());
+	execute(putStatement);
+}
+
+void KeyValueStore::put(const std::vector<std::pair<std::string, std::string>>& entries) {
+	sqlite3* connectionHandle = const_cast<sqlite3*>(&connection.getConnectionHandle());
+	if(sqlite3_get_autocommit(connectionHandle) == 0) {
+		for(const auto& entry : entries) {
+			put(entry.first, entry.second);
+		}
+		return;
+	}
+
+	connection.prepareSQLite("BEGIN IMMEDIATE;").step();
+	try {
+		for(const auto& entry : entries) {
+			put(entry.first, entry.second);
+		}
+	}
+	catch(...) {
+		if(sqlite3_get_autocommit(connectionHandle) == 0) {
+			connection.rollback();
+		}
+		throw;
+	}
+	connection.commit();
+}
+
+bool KeyValueStore::remove(const std::string& key) {
+	removeStatement.bindBlob(0, key.data(), key.size());
+	execute(removeStatement);
+
+	return sqlite3_changes(sqlite3_db_handle(&removeStatement.getHandle())) > 0;
+}
+
+StatementHandle KeyValueStore::prepare(const std::string& sql) {
+	HandleContext* handleContext = connection.getHandleContext();
+	if(handleContext && handleContext->hotStatements) {
+		/* prepared with SQLITE_PREPARE_PERSISTENT and kept for the next store on this handle */
+		handleContext->hotStatements->add(sql);
+	}
+	return connection.prepareSQLite(sql);
+}
+
+const StatementHandle& KeyValueStore::getMultiGetStatement(std::size_t keys) {
+	std::size_t parameters = 1;
+	while(parameters < keys) {
+		parameters *= 2;
+	}
+
+	StatementHandle& statementHandle = multiGetStatements[parameters];
+	if(!statementHandle) {
+		std::string sql = "SELECT key, value FROM " + table + " WHERE key IN (?";
+		for(std::size_t i = 1; i < parameters; ++i) {
+			sql += ", ?";
+		}
+		sql += ");";
+		statementHandle = prepare(sql);
+	}
+
+	return statementHandle;
+}
+
+void KeyValueStore::execute(const StatementHandle& statementHandle) {
+	try {
+		statementHandle.step();
+	}
+	catch(...) {
+		sqlite3_reset(&statementHandle.getHandle());
+		throw;
+	}
+	statementHandle.reset();
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
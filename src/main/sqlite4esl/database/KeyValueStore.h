@@ -0,0 +1,80 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_KEYVALUESTORE_H_
+#define SQLITE4ESL_DATABASE_KEYVALUESTORE_H_
+
+#include <sqlite4esl/database/StatementHandle.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+class Connection;
+
+/* Get, put and remove on a table "(key BLOB PRIMARY KEY, value BLOB) WITHOUT ROWID"
+ * without the field conversion of prepared statements. The statements are prepared
+ * once and pinned to the handle (see HotStatements), keys and values are bound without
+ * copying. Like the connection a store is used by one thread and it has to be destroyed
+ * before the connection. */
+class KeyValueStore {
+public:
+	/* Creates table "table" if it does not exist */
+	KeyValueStore(const Connection& connection, const std::string& table = "kv");
+	KeyValueStore(const KeyValueStore&) = delete;
+
+	KeyValueStore& operator=(const KeyValueStore&) = delete;
+
+	/* Returns false if "key" does not exist */
+	bool get(const std::string& key, std::string& value);
+	/* Returns the values of the existing keys, read in batches of up to 256 keys */
+	std::map<std::string, std::string> get(const std::vector<std::string>& keys);
+
+	void put(const std::string& key, const std::string& value);
+	/* Writes all entries in one transaction, or in the current transaction if there is one */
+	void put(const std::vector<std::pair<std::string, std::string>>& entries);
+
+	/* Returns false if "key" does not exist */
+	bool remove(const std::string& key);
+
+private:
+	StatementHandle prepare(const std::string& sql);
+	/* IN lists have 2^n parameters, so only a few statements are prepared */
+	const StatementHandle& getMultiGetStatement(std::size_t keys);
+	void execute(const StatementHandle& statementHandle);
+
+	const Connection& connection;
+	std::string table;
+
+	StatementHandle getStatement;
+	StatementHandle putStatement;
+	StatementHandle removeStatement;
+	std::map<std::size_t, StatementHandle> multiGetStatements;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_KEYVALUESTORE_H_ */
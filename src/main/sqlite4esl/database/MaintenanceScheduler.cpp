@@ -0,0 +1,209 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/MaintenanceScheduler.h>
+
+#include <esl/Logger.h>
+
+#include <algorithm>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::MaintenanceScheduler");
+
+/* Returns -1 on error */
+sqlite3_int64 queryInt64(sqlite3& connectionHandle, const char* sql) {
+	sqlite3_int64 value = -1;
+	sqlite3_stmt* stmt = nullptr;
+	if(sqlite3_prepare_v2(&connectionHandle, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+		value = sqlite3_column_int64(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
+	return value;
+}
+
+std::chrono::steady_clock::rep now() noexcept {
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+}
+
+MaintenanceScheduler::MaintenanceScheduler(sqlite3& aConnectionHandle, IdleHandle aIdleHandle, std::chrono::milliseconds aInterval, std::chrono::milliseconds aIdleDelay, std::chrono::milliseconds aBudget, int analysisLimit, int vacuumPages, int progressInstructions)
+: connectionHandle(aConnectionHandle),
+  executionControl(connectionHandle, progressInstructions),
+  idleHandle(std::move(aIdleHandle)),
+  interval(aInterval),
+  idleDelay(aIdleDelay),
+  budget(aBudget),
+  optimizeSql("PRAGMA analysis_limit = " + std::to_string(analysisLimit) + "; PRAGMA optimize;"),
+  lastActivity(now())
+{
+	/* maintenance gives way to the application instead of waiting for locks */
+	sqlite3_busy_timeout(&connectionHandle, 0);
+
+	if(vacuumPages > 0) {
+		sqlite3_int64 autoVacuum = queryInt64(connectionHandle, "PRAGMA auto_vacuum;");
+		if(autoVacuum == 2) {
+			incrementalVacuumSql = "PRAGMA incremental_vacuum(" + std::to_string(vacuumPages) + ");";
+		}
+		else {
+			logger.info << "Incremental vacuum is disabled, because auto_vacuum is " << autoVacuum << " instead of 2 (INCREMENTAL)\n";
+		}
+	}
+
+	thread = std::thread(&MaintenanceScheduler::run, this);
+}
+
+MaintenanceScheduler::~MaintenanceScheduler() {
+	stop();
+}
+
+void MaintenanceScheduler::stop() {
+	if(!thread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	condition.notify_all();
+	thread.join();
+}
+
+void MaintenanceScheduler::acquired() noexcept {
+	activeConnections.fetch_add(1, std::memory_order_relaxed);
+	lastActivity.store(now(), std::memory_order_relaxed);
+}
+
+void MaintenanceScheduler::released() noexcept {
+	lastActivity.store(now(), std::memory_order_relaxed);
+	activeConnections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool MaintenanceScheduler::hasActiveConnections() const noexcept {
+	return activeConnections.load(std::memory_order_relaxed) > 0;
+}
+
+void MaintenanceScheduler::optimize(sqlite3& aConnectionHandle, ExecutionControl& aExecutionControl) {
+	/* pooled handles keep the analysis limit of the application */
+	sqlite3_int64 previousAnalysisLimit = queryInt64(aConnectionHandle, "PRAGMA analysis_limit;");
+	execute(aConnectionHandle, aExecutionControl, budget, optimizeSql.c_str(), statistics.optimizeRuns);
+	if(previousAnalysisLimit >= 0) {
+		std::string sql = "PRAGMA analysis_limit = " + std::to_string(previousAnalysisLimit) + ";";
+		sqlite3_exec(&aConnectionHandle, sql.c_str(), nullptr, nullptr, nullptr);
+	}
+}
+
+MaintenanceScheduler::Statistics MaintenanceScheduler::getStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+void MaintenanceScheduler::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while(!stopped) {
+		condition.wait_for(lock, interval, [this] {
+			return stopped;
+		});
+		if(stopped) {
+			break;
+		}
+
+		lock.unlock();
+		idleHandle([this](sqlite3& idleConnectionHandle, ExecutionControl& idleExecutionControl) {
+			optimize(idleConnectionHandle, idleExecutionControl);
+		});
+		incrementalVacuum();
+		lock.lock();
+	}
+}
+
+bool MaintenanceScheduler::isIdle() const noexcept {
+	if(hasActiveConnections()) {
+		return false;
+	}
+	std::chrono::steady_clock::duration idle(now() - lastActivity.load(std::memory_order_relaxed));
+	return idle >= idleDelay;
+}
+
+void MaintenanceScheduler::incrementalVacuum() {
+	if(incrementalVacuumSql.empty()) {
+		return;
+	}
+
+	/* the budget applies to all steps of one idle period together */
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while(isIdle()) {
+		sqlite3_int64 freePages = queryInt64(connectionHandle, "PRAGMA freelist_count;");
+		std::chrono::milliseconds remaining = budget - std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		if(freePages <= 0 || remaining.count() <= 0) {
+			break;
+		}
+
+		if(execute(connectionHandle, executionControl, remaining, incrementalVacuumSql.c_str(), statistics.incrementalVacuumSteps) != SQLITE_OK) {
+			break;
+		}
+
+		sqlite3_int64 remainingFreePages = queryInt64(connectionHandle, "PRAGMA freelist_count;");
+		if(remainingFreePages >= 0 && remainingFreePages < freePages) {
+			std::lock_guard<std::mutex> lock(mutex);
+			statistics.freedPages += static_cast<std::uint64_t>(freePages - remainingFreePages);
+		}
+	}
+}
+
+int MaintenanceScheduler::execute(sqlite3& aConnectionHandle, ExecutionControl& aExecutionControl, std::chrono::milliseconds aBudget, const char* sql, std::uint64_t& runs) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point deadline = start + aBudget;
+	aExecutionControl.arm(&deadline, nullptr, nullptr);
+	int rc = sqlite3_exec(&aConnectionHandle, sql, nullptr, nullptr, nullptr);
+	aExecutionControl.disarm();
+	std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	statistics.lastDuration = duration;
+	statistics.maxDuration = std::max(statistics.maxDuration, duration);
+	statistics.totalDuration += duration;
+
+	switch(rc & 0xff) {
+	case SQLITE_OK:
+		++runs;
+		break;
+	case SQLITE_INTERRUPT:
+		++statistics.interruptedRuns;
+		break;
+	case SQLITE_BUSY:
+	case SQLITE_LOCKED:
+		++statistics.busyRuns;
+		break;
+	default:
+		++statistics.failedRuns;
+		logger.warn << "Maintenance \"" << sql << "\" failed: " << sqlite3_errmsg(&aConnectionHandle) << "\n";
+		break;
+	}
+
+	return rc;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
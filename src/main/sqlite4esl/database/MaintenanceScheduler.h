@@ -0,0 +1,119 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_MAINTENANCESCHEDULER_H_
+#define SQLITE4ESL_DATABASE_MAINTENANCESCHEDULER_H_
+
+#include <sqlite4esl/database/ExecutionControl.h>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Runs database maintenance on a background thread. Every interval it runs
+ * PRAGMA optimize on one idle pooled handle, because optimize only analyzes tables
+ * whose statistics the query planner of that handle has missed. ANALYZE is limited by
+ * PRAGMA analysis_limit. If no connection has been in use for "idleDelay", it also frees
+ * pages by PRAGMA incremental_vacuum in steps of "vacuumPages" pages on its own handle,
+ * which requires auto_vacuum = INCREMENTAL.
+ * Every run is interrupted by the ExecutionControl of its handle once it exceeds
+ * "budget", so a writer never waits longer than that for maintenance. */
+class MaintenanceScheduler {
+public:
+	struct Statistics {
+		std::uint64_t optimizeRuns = 0;
+		std::uint64_t incrementalVacuumSteps = 0;
+		std::uint64_t freedPages = 0;
+		/* runs that exceeded the budget and have been rolled back */
+		std::uint64_t interruptedRuns = 0;
+		/* runs skipped because another handle held a lock */
+		std::uint64_t busyRuns = 0;
+		std::uint64_t failedRuns = 0;
+
+		std::chrono::microseconds lastDuration{0};
+		std::chrono::microseconds maxDuration{0};
+		std::chrono::microseconds totalDuration{0};
+	};
+
+	/* Calls the function with an idle pooled handle and its execution control and
+	 * returns true, or returns false if no handle is idle. A shared handle is idle
+	 * while no connection uses it. */
+	using IdleHandle = std::function<bool(const std::function<void(sqlite3&, ExecutionControl&)>&)>;
+
+	/* "connectionHandle" is used by the maintenance thread exclusively and must
+	 * outlive the scheduler */
+	MaintenanceScheduler(sqlite3& connectionHandle, IdleHandle idleHandle, std::chrono::milliseconds interval, std::chrono::milliseconds idleDelay, std::chrono::milliseconds budget, int analysisLimit, int vacuumPages, int progressInstructions);
+	~MaintenanceScheduler();
+
+	/* Stops the maintenance thread, optimize() can still be used afterwards */
+	void stop();
+
+	/* Called by the connection factory when a connection is created or released */
+	void acquired() noexcept;
+	void released() noexcept;
+	bool hasActiveConnections() const noexcept;
+
+	/* Runs PRAGMA optimize on "connectionHandle" within the budget, e.g. before the
+	 * handle is closed. The analysis limit of the handle is restored afterwards. */
+	void optimize(sqlite3& connectionHandle, ExecutionControl& executionControl);
+
+	Statistics getStatistics() const;
+
+private:
+	void run();
+	bool isIdle() const noexcept;
+	void incrementalVacuum();
+	/* Returns the result code of "sql" */
+	int execute(sqlite3& connectionHandle, ExecutionControl& executionControl, std::chrono::milliseconds budget, const char* sql, std::uint64_t& runs);
+
+	sqlite3& connectionHandle;
+	ExecutionControl executionControl;
+	IdleHandle idleHandle;
+	const std::chrono::milliseconds interval;
+	const std::chrono::milliseconds idleDelay;
+	const std::chrono::milliseconds budget;
+	const std::string optimizeSql;
+	std::string incrementalVacuumSql;
+
+	std::atomic<int> activeConnections{0};
+	std::atomic<std::chrono::steady_clock::rep> lastActivity;
+
+	mutable std::mutex mutex;
+	std::condition_variable condition;
+	bool stopped = false;
+	Statistics statistics;
+
+	std::thread thread;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_MAINTENANCESCHEDULER_H_ */
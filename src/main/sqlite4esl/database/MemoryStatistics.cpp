@@ -0,0 +1,100 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/MemoryStatistics.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+std::int64_t dbStatus(sqlite3& connectionHandle, int op, bool reset) {
+	int current = 0;
+	int highwater = 0;
+	sqlite3_db_status(&connectionHandle, op, &current, &highwater, reset ? 1 : 0);
+
+	/* counters of hits and misses are reported as highwater */
+	switch(op) {
+	case SQLITE_DBSTATUS_LOOKASIDE_HIT:
+	case SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE:
+	case SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL:
+		return highwater;
+	default:
+		return current;
+	}
+}
+
+void status(int op, std::int64_t& current, std::int64_t& highwater, bool reset) {
+	sqlite3_int64 currentValue = 0;
+	sqlite3_int64 highwaterValue = 0;
+	sqlite3_status64(op, &currentValue, &highwaterValue, reset ? 1 : 0);
+	current = currentValue;
+	highwater = highwaterValue;
+}
+}
+
+MemoryStatistics MemoryStatistics::get(sqlite3& connectionHandle, bool reset) {
+	MemoryStatistics statistics;
+
+	statistics.cacheHits = dbStatus(connectionHandle, SQLITE_DBSTATUS_CACHE_HIT, reset);
+	statistics.cacheMisses = dbStatus(connectionHandle, SQLITE_DBSTATUS_CACHE_MISS, reset);
+	statistics.cacheWrites = dbStatus(connectionHandle, SQLITE_DBSTATUS_CACHE_WRITE, reset);
+	statistics.cacheSpills = dbStatus(connectionHandle, SQLITE_DBSTATUS_CACHE_SPILL, reset);
+	statistics.cacheUsed = dbStatus(connectionHandle, SQLITE_DBSTATUS_CACHE_USED, false);
+
+	statistics.lookasideHits = dbStatus(connectionHandle, SQLITE_DBSTATUS_LOOKASIDE_HIT, reset);
+	statistics.lookasideMissesSize = dbStatus(connectionHandle, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, reset);
+	statistics.lookasideMissesFull = dbStatus(connectionHandle, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, reset);
+	statistics.lookasideUsed = dbStatus(connectionHandle, SQLITE_DBSTATUS_LOOKASIDE_USED, reset);
+
+	statistics.schemaUsed = dbStatus(connectionHandle, SQLITE_DBSTATUS_SCHEMA_USED, false);
+	statistics.statementsUsed = dbStatus(connectionHandle, SQLITE_DBSTATUS_STMT_USED, false);
+
+	return statistics;
+}
+
+MemoryStatistics& MemoryStatistics::operator+=(const MemoryStatistics& other) noexcept {
+	cacheHits += other.cacheHits;
+	cacheMisses += other.cacheMisses;
+	cacheWrites += other.cacheWrites;
+	cacheSpills += other.cacheSpills;
+	cacheUsed += other.cacheUsed;
+	lookasideHits += other.lookasideHits;
+	lookasideMissesSize += other.lookasideMissesSize;
+	lookasideMissesFull += other.lookasideMissesFull;
+	lookasideUsed += other.lookasideUsed;
+	schemaUsed += other.schemaUsed;
+	statementsUsed += other.statementsUsed;
+
+	return *this;
+}
+
+GlobalMemoryStatistics GlobalMemoryStatistics::get(bool reset) {
+	GlobalMemoryStatistics statistics;
+	std::int64_t unused = 0;
+
+	status(SQLITE_STATUS_MEMORY_USED, statistics.memoryUsed, statistics.memoryHighwater, reset);
+	status(SQLITE_STATUS_PAGECACHE_USED, statistics.pageCacheUsed, statistics.pageCacheHighwater, reset);
+	status(SQLITE_STATUS_PAGECACHE_OVERFLOW, statistics.pageCacheOverflow, unused, reset);
+
+	return statistics;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,74 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_MEMORYSTATISTICS_H_
+#define SQLITE4ESL_DATABASE_MEMORYSTATISTICS_H_
+
+#include <sqlite3.h>
+
+#include <cstdint>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Memory and page cache counters of a handle (sqlite3_db_status) */
+struct MemoryStatistics {
+	std::int64_t cacheHits = 0;
+	std::int64_t cacheMisses = 0;
+	std::int64_t cacheWrites = 0;
+	std::int64_t cacheSpills = 0;
+	/* bytes */
+	std::int64_t cacheUsed = 0;
+
+	std::int64_t lookasideHits = 0;
+	std::int64_t lookasideMissesSize = 0;
+	std::int64_t lookasideMissesFull = 0;
+	/* slots */
+	std::int64_t lookasideUsed = 0;
+
+	/* bytes */
+	std::int64_t schemaUsed = 0;
+	std::int64_t statementsUsed = 0;
+
+	/* "reset" resets the hit/miss counters and the highwater marks */
+	static MemoryStatistics get(sqlite3& connectionHandle, bool reset = false);
+
+	MemoryStatistics& operator+=(const MemoryStatistics& other) noexcept;
+};
+
+/* Process wide allocator counters (sqlite3_status64) */
+struct GlobalMemoryStatistics {
+	/* bytes */
+	std::int64_t memoryUsed = 0;
+	std::int64_t memoryHighwater = 0;
+
+	/* slots of the SQLITE_CONFIG_PAGECACHE slab */
+	std::int64_t pageCacheUsed = 0;
+	std::int64_t pageCacheHighwater = 0;
+	/* bytes that did not fit into the slab */
+	std::int64_t pageCacheOverflow = 0;
+
+	static GlobalMemoryStatistics get(bool reset = false);
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_MEMORYSTATISTICS_H_ */
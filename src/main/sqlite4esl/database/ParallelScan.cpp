@@ -0,0 +1,287 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/ParallelScan.h>
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/StatementHandle.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <esl/Logger.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::ParallelScan");
+
+std::string quoteIdentifier(const std::string& identifier) {
+	std::string quoted = "\"";
+	for(char c : identifier) {
+		if(c == '"') {
+			quoted += '"';
+		}
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+bool isLess(const esl::database::Field& a, const esl::database::Field& b) {
+	if(a.getSimpleType() == esl::database::Field::Type::storageString || b.getSimpleType() == esl::database::Field::Type::storageString) {
+		return a.asString() < b.asString();
+	}
+	return a.asDouble() < b.asDouble();
+}
+}
+
+ParallelScan::ParallelScan(ConnectionFactory& aConnectionFactory, std::string aTable, std::string aKeyColumn)
+: connectionFactory(aConnectionFactory),
+  table(std::move(aTable)),
+  keyColumn(std::move(aKeyColumn))
+{ }
+
+void ParallelScan::run(std::size_t partitions, const std::string& columns, const std::string& condition, RowConsumer consumer) {
+	run(partitions, columns, condition, std::move(consumer), nullptr);
+}
+
+void ParallelScan::runMerged(std::size_t partitions, const std::string& columns, const std::string& condition, Merge merge) {
+	std::vector<std::vector<Row>> partitionRows(std::max<std::size_t>(partitions, 1));
+	std::mutex mergeMutex;
+
+	run(partitions, columns, condition, [&partitionRows](std::size_t partition, const Row& row) {
+		partitionRows[partition].push_back(row);
+	}, [&](std::size_t partition) {
+		std::lock_guard<std::mutex> lock(mergeMutex);
+		merge(partition, partitionRows[partition]);
+		std::vector<Row>().swap(partitionRows[partition]);
+	});
+}
+
+void ParallelScan::run(std::size_t partitions, const std::string& columns, const std::string& condition, RowConsumer consumer, std::function<void(std::size_t partition)> partitionDone) {
+	/* the coordinator handle scans the first partition */
+	int maxConnections = connectionFactory.getSettings().maxConnections;
+	partitions = std::max<std::size_t>(std::min<std::size_t>(partitions, maxConnections > 1 ? static_cast<std::size_t>(maxConnections) : 1), 1);
+
+	std::unique_ptr<esl::database::Connection> coordinator = connectionFactory.createConnection();
+	if(!coordinator) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot scan table \"" + table + "\", because no connection is available"));
+	}
+	const Connection& coordinatorConnection = static_cast<Connection&>(*coordinator);
+
+	/* the read transaction of the coordinator keeps the snapshot available */
+	coordinatorConnection.prepareSQLite("BEGIN").step();
+
+	std::vector<esl::database::Field> boundaries;
+	bool useSnapshot = false;
+#ifdef SQLITE_ENABLE_SNAPSHOT
+	sqlite3_snapshot* snapshot = nullptr;
+#endif
+	try {
+		boundaries = getBoundaries(coordinatorConnection, partitions);
+		partitions = boundaries.size() + 1;
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+		if(partitions > 1) {
+			sqlite3& coordinatorHandle = const_cast<sqlite3&>(coordinatorConnection.getConnectionHandle());
+			int rc = sqlite3_snapshot_get(&coordinatorHandle, "main", &snapshot);
+			if(rc == SQLITE_OK) {
+				useSnapshot = true;
+			}
+			else {
+				logger.warn << "No snapshot of table \"" << table << "\" (" << sqlite3_errstr(rc) << "), partitions are read in their own transactions\n";
+				snapshot = nullptr;
+			}
+		}
+#endif
+	}
+	catch(...) {
+		coordinatorConnection.prepareSQLite("ROLLBACK").step();
+		throw;
+	}
+	if(partitions > 1 && !useSnapshot) {
+		logger.debug << "Partitions of table \"" << table << "\" are read in their own transactions\n";
+	}
+
+	std::string sqlPrefix = "SELECT " + columns + " FROM " + quoteIdentifier(table) + " WHERE ";
+	std::string sqlSuffix = condition.empty() ? "" : " AND (" + condition + ")";
+	std::string key = quoteIdentifier(keyColumn);
+
+	auto scan = [&](std::size_t partition, const Connection& connection) {
+		std::string range;
+		std::vector<esl::database::Field> parameters;
+		if(partitions == 1) {
+			range = "1";
+		}
+		else if(partition == 0) {
+			range = isRowid() ? key + " < ?" : "(" + key + " < ? OR " + key + " IS NULL)";
+			parameters.push_back(boundaries[0]);
+		}
+		else if(partition + 1 == partitions) {
+			range = key + " >= ?";
+			parameters.push_back(boundaries[partition - 1]);
+		}
+		else {
+			range = key + " >= ? AND " + key + " < ?";
+			parameters.push_back(boundaries[partition - 1]);
+			parameters.push_back(boundaries[partition]);
+		}
+
+		StatementHandle statementHandle = connection.prepareSQLite(sqlPrefix + range + sqlSuffix);
+		if(!sqlite3_stmt_readonly(&statementHandle.getHandle())) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Parallel scan of table \"" + table + "\" is not read only"));
+		}
+		statementHandle.bind(parameters);
+
+		Row row(statementHandle.columnCount());
+		while(statementHandle.step()) {
+			statementHandle.columns(row);
+			consumer(partition, row);
+		}
+	};
+
+	std::vector<std::exception_ptr> errors(partitions);
+	std::vector<std::thread> threads;
+	for(std::size_t partition=1; partition<partitions; ++partition) {
+		threads.emplace_back([&, partition]() {
+			try {
+				std::unique_ptr<esl::database::Connection> worker = connectionFactory.createConnection();
+				if(!worker) {
+			        throw esl::system::Stacktrace::add(std::runtime_error("Cannot scan partition " + std::to_string(partition) + " of table \"" + table + "\", because no connection is available"));
+				}
+				const Connection& workerConnection = static_cast<Connection&>(*worker);
+
+				workerConnection.prepareSQLite("BEGIN").step();
+				try {
+#ifdef SQLITE_ENABLE_SNAPSHOT
+					if(useSnapshot) {
+						int rc = sqlite3_snapshot_open(const_cast<sqlite3*>(&workerConnection.getConnectionHandle()), "main", snapshot);
+						if(rc != SQLITE_OK) {
+						    throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot open snapshot", rc, const_cast<sqlite3*>(&workerConnection.getConnectionHandle())));
+						}
+					}
+#endif
+					scan(partition, workerConnection);
+				}
+				catch(...) {
+					workerConnection.prepareSQLite("ROLLBACK").step();
+					throw;
+				}
+				workerConnection.prepareSQLite("COMMIT").step();
+
+				if(partitionDone) {
+					partitionDone(partition);
+				}
+			}
+			catch(...) {
+				errors[partition] = std::current_exception();
+			}
+		});
+	}
+
+	try {
+		scan(0, coordinatorConnection);
+		if(partitionDone) {
+			partitionDone(0);
+		}
+	}
+	catch(...) {
+		errors[0] = std::current_exception();
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+	if(snapshot) {
+		sqlite3_snapshot_free(snapshot);
+	}
+#endif
+	coordinatorConnection.prepareSQLite(errors[0] ? "ROLLBACK" : "COMMIT").step();
+
+	for(const auto& error : errors) {
+		if(error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+std::vector<esl::database::Field> ParallelScan::getBoundaries(const Connection& connection, std::size_t partitions) const {
+	std::vector<esl::database::Field> boundaries;
+	if(partitions <= 1) {
+		return boundaries;
+	}
+
+	std::string key = quoteIdentifier(keyColumn);
+
+	if(isRowid()) {
+		StatementHandle statementHandle = connection.prepareSQLite("SELECT min(" + key + "), max(" + key + ") FROM " + quoteIdentifier(table));
+		if(!statementHandle.step() || statementHandle.columnValueIsNull(0)) {
+			return boundaries;
+		}
+
+		std::int64_t minRowid = statementHandle.columnInteger(0);
+		std::uint64_t span = static_cast<std::uint64_t>(statementHandle.columnInteger(1)) - static_cast<std::uint64_t>(minRowid) + 1;
+		for(std::size_t i=1; i<partitions; ++i) {
+			std::uint64_t offset = span / partitions * i + span % partitions * i / partitions;
+			boundaries.push_back(esl::database::Field(static_cast<std::int64_t>(static_cast<std::uint64_t>(minRowid) + offset)));
+		}
+	}
+	else {
+		/* quantiles of the index, equal quantiles give fewer partitions */
+		StatementHandle countStatement = connection.prepareSQLite("SELECT count(" + key + ") FROM " + quoteIdentifier(table));
+		countStatement.step();
+		std::int64_t count = countStatement.columnInteger(0);
+
+		StatementHandle statementHandle = connection.prepareSQLite("SELECT " + key + " FROM " + quoteIdentifier(table) + " WHERE " + key + " IS NOT NULL ORDER BY " + key + " LIMIT 1 OFFSET ?");
+		std::vector<esl::database::Field> row(1);
+		for(std::size_t i=1; i<partitions && count > 0; ++i) {
+			statementHandle.bindInteger(0, count * static_cast<std::int64_t>(i) / static_cast<std::int64_t>(partitions));
+			if(statementHandle.step()) {
+				statementHandle.columns(row);
+				if(boundaries.empty() || isLess(boundaries.back(), row[0])) {
+					boundaries.push_back(row[0]);
+				}
+			}
+			statementHandle.reset();
+		}
+	}
+
+	return boundaries;
+}
+
+bool ParallelScan::isRowid() const {
+	return sqlite3_stricmp(keyColumn.c_str(), "rowid") == 0
+			|| sqlite3_stricmp(keyColumn.c_str(), "_rowid_") == 0
+			|| sqlite3_stricmp(keyColumn.c_str(), "oid") == 0;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,75 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_PARALLELSCAN_H_
+#define SQLITE4ESL_DATABASE_PARALLELSCAN_H_
+
+#include <sqlite4esl/database/ConnectionFactory.h>
+
+#include <esl/database/Field.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Splits a scan of one table into key ranges and runs every range on its own pooled
+ * handle and thread, e.g. for aggregations over large tables. The ranges are split by
+ * the rowid or by an indexed column. With SQLITE_ENABLE_SNAPSHOT and a database in WAL
+ * mode all partitions read the same snapshot, otherwise every partition reads in its
+ * own transaction. The number of partitions is limited by "maxConnections" and the
+ * scan waits for free handles, so it must not run while the calling thread holds
+ * connections of the same factory. */
+class Connection;
+
+class ParallelScan {
+public:
+	using Row = std::vector<esl::database::Field>;
+	/* Called on the thread of the partition, so it has to be thread safe */
+	using RowConsumer = std::function<void(std::size_t partition, const Row& row)>;
+	/* Called once per partition with its rows as soon as the partition is done, calls
+	 * are serialized */
+	using Merge = std::function<void(std::size_t partition, std::vector<Row>& rows)>;
+
+	/* "keyColumn" is "rowid" or a column with an index */
+	ParallelScan(ConnectionFactory& connectionFactory, std::string table, std::string keyColumn = "rowid");
+
+	/* Runs "SELECT <columns> FROM <table> WHERE <key range> [AND (<condition>)]" with up
+	 * to "partitions" partitions, "columns" may contain aggregates of a partition */
+	void run(std::size_t partitions, const std::string& columns, const std::string& condition, RowConsumer consumer);
+	void runMerged(std::size_t partitions, const std::string& columns, const std::string& condition, Merge merge);
+
+private:
+	void run(std::size_t partitions, const std::string& columns, const std::string& condition, RowConsumer consumer, std::function<void(std::size_t partition)> partitionDone);
+	std::vector<esl::database::Field> getBoundaries(const Connection& connection, std::size_t partitions) const;
+	bool isRowid() const;
+
+	ConnectionFactory& connectionFactory;
+	std::string table;
+	std::string keyColumn;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_PARALLELSCAN_H_ */
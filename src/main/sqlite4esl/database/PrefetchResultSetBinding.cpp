@@ -0,0 +1,149 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/PrefetchResultSetBinding.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+PrefetchResultSetBinding::PrefetchResultSetBinding(StatementHandle&& aStatementHandle, const std::vector<esl::database::Column>& resultColumns, std::size_t slotCount)
+: esl::database::ResultSet::Binding(resultColumns),
+  statementHandle(std::move(aStatementHandle)),
+  slots(slotCount > 0 ? slotCount : 1, std::vector<esl::database::Field>(resultColumns.size())),
+  wakeUpSlots(slots.size() / 8 > 0 ? slots.size() / 8 : 1)
+{
+	thread = std::thread(&PrefetchResultSetBinding::produce, this);
+}
+
+PrefetchResultSetBinding::~PrefetchResultSetBinding() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	notFull.notify_one();
+	thread.join();
+}
+
+bool PrefetchResultSetBinding::fetch(std::vector<esl::database::Field>& fields) {
+	if(fields.size() != getColumns().size()) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Called 'fetch' with wrong number of fields. Given " + std::to_string(fields.size()) + " fields, but it should be " + std::to_string(getColumns().size()) + " fields."));
+	}
+
+	bool notifyProducer = false;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while(count == 0 && !done) {
+			consumerWaiting = true;
+			notEmpty.wait(lock);
+			consumerWaiting = false;
+		}
+
+		if(count == 0) {
+			if(error) {
+				std::exception_ptr producerError = error;
+				error = nullptr;
+				std::rethrow_exception(producerError);
+			}
+			return false;
+		}
+
+		/* the slot gets the vector of the caller, so no row is copied or allocated */
+		fields.swap(slots[tail]);
+		tail = (tail + 1) % slots.size();
+		--count;
+		notifyProducer = producerWaiting && slots.size() - count >= wakeUpSlots;
+	}
+
+	if(notifyProducer) {
+		notFull.notify_one();
+	}
+	return true;
+}
+
+bool PrefetchResultSetBinding::isEditable(std::size_t columnIndex) {
+	return false;
+}
+
+void PrefetchResultSetBinding::add(std::vector<esl::database::Field>& fields) {
+    throw esl::system::Stacktrace::add(std::runtime_error("add not allowed for query result set."));
+}
+
+void PrefetchResultSetBinding::save(std::vector<esl::database::Field>& fields) {
+    throw esl::system::Stacktrace::add(std::runtime_error("save not allowed for query result set."));
+}
+
+void PrefetchResultSetBinding::produce() {
+	try {
+		/* the first row has been stepped already */
+		bool hasRow = true;
+		while(hasRow) {
+			std::size_t slot;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while(count == slots.size() && !stopped) {
+					producerWaiting = true;
+					notFull.wait(lock);
+					producerWaiting = false;
+				}
+				if(stopped) {
+					break;
+				}
+				slot = head;
+			}
+
+			/* slots from "head" on are not read by fetch() until "count" covers them */
+			statementHandle.columns(slots[slot]);
+
+			bool notifyConsumer = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				head = (head + 1) % slots.size();
+				++count;
+				notifyConsumer = consumerWaiting && count >= wakeUpSlots;
+			}
+			if(notifyConsumer) {
+				notEmpty.notify_one();
+			}
+
+			hasRow = statementHandle.step();
+		}
+
+		/* ends the read transaction of an autocommit statement early */
+		statementHandle.reset();
+	}
+	catch(...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		error = std::current_exception();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+	}
+	notEmpty.notify_one();
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
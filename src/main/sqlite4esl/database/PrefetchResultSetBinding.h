@@ -0,0 +1,84 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_PREFETCHRESULTSETBINDING_H_
+#define SQLITE4ESL_DATABASE_PREFETCHRESULTSETBINDING_H_
+
+#include <sqlite4esl/database/StatementHandle.h>
+
+#include <esl/database/ResultSet.h>
+#include <esl/database/Column.h>
+#include <esl/database/Field.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Steps the statement on a producer thread, which decodes the rows into a bounded
+ * ring of preallocated row slots. fetch() swaps a filled slot with the fields of the
+ * caller, so stepping sqlite3 and processing rows overlap. The handle is used by the
+ * producer until all rows are read or the result set is destroyed, so the connection
+ * must not be used in the meantime. */
+class PrefetchResultSetBinding : public esl::database::ResultSet::Binding {
+public:
+	/* "statementHandle" has to be stepped to its first row */
+	PrefetchResultSetBinding(StatementHandle&& statementHandle, const std::vector<esl::database::Column>& resultColumns, std::size_t slots);
+	~PrefetchResultSetBinding();
+
+	bool fetch(std::vector<esl::database::Field>& fields) override;
+	bool isEditable(std::size_t columnIndex) override;
+	void add(std::vector<esl::database::Field>& fields) override;
+	void save(std::vector<esl::database::Field>& fields) override;
+
+private:
+	void produce();
+
+	StatementHandle statementHandle;
+	std::vector<std::vector<esl::database::Field>> slots;
+	/* a waiting thread is woken up once this many slots are filled or free, so the
+	 * threads do not switch for every row */
+	std::size_t wakeUpSlots;
+
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	/* next slot written by the producer and next slot read by fetch() */
+	std::size_t head = 0;
+	std::size_t tail = 0;
+	std::size_t count = 0;
+	bool consumerWaiting = false;
+	bool producerWaiting = false;
+	bool done = false;
+	bool stopped = false;
+	std::exception_ptr error;
+
+	std::thread thread;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_PREFETCHRESULTSETBINDING_H_ */
@@ -17,6 +17,7 @@
  */
 
 #include <sqlite4esl/database/PreparedBulkStatementBinding.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
 #include <sqlite4esl/database/ResultSetBinding.h>
 
 #include <esl/Logger.h>
@@ -25,6 +26,9 @@
 
 #include <esl/system/Stacktrace.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <stdexcept>
 
 namespace sqlite4esl {
@@ -33,6 +37,56 @@ namespace database {
 
 namespace {
 esl::Logger logger("sqlite4esl::database::PreparedBulkStatementBinding");
+
+bool startsWithKeyword(const std::string& sql, std::string::size_type position, const char* keyword) {
+	std::string::size_type length = std::strlen(keyword);
+	if(sql.size() < position + length) {
+		return false;
+	}
+	for(std::string::size_type i = 0; i < length; ++i) {
+		if(std::toupper(static_cast<unsigned char>(sql[position + i])) != keyword[i]) {
+			return false;
+		}
+	}
+	return sql.size() == position + length || !(std::isalnum(static_cast<unsigned char>(sql[position + length])) || sql[position + length] == '_');
+}
+
+/* Splits "INSERT ... VALUES (?, ?)" into "INSERT ... VALUES" and "(?, ?)". Only anonymous
+ * parameters are accepted and nothing but ";" may follow the values list. */
+bool getValuesList(const std::string& sql, std::string& prefix, std::string& valuesList) {
+	std::string::size_type position = sql.find_first_not_of(" \t\r\n");
+	if(position == std::string::npos || !(startsWithKeyword(sql, position, "INSERT") || startsWithKeyword(sql, position, "REPLACE"))) {
+		return false;
+	}
+
+	std::string::size_type end = sql.find_last_not_of(" \t\r\n;");
+	if(end == std::string::npos || sql[end] != ')') {
+		return false;
+	}
+
+	std::string::size_type begin = sql.rfind('(', end);
+	if(begin == std::string::npos) {
+		return false;
+	}
+	for(std::string::size_type i = begin + 1; i < end; ++i) {
+		char c = sql[i];
+		if(c != '?' && c != ',' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+			return false;
+		}
+	}
+
+	std::string::size_type valuesEnd = sql.find_last_not_of(" \t\r\n", begin - 1);
+	if(valuesEnd == std::string::npos || valuesEnd < 5 || !startsWithKeyword(sql, valuesEnd - 5, "VALUES")) {
+		return false;
+	}
+	if(valuesEnd > 5 && (std::isalnum(static_cast<unsigned char>(sql[valuesEnd - 6])) || sql[valuesEnd - 6] == '_')) {
+		return false;
+	}
+
+	prefix = sql.substr(0, valuesEnd + 1);
+	valuesList = sql.substr(begin, end - begin + 1);
+	return true;
+}
 }
 
 PreparedBulkStatementBinding::PreparedBulkStatementBinding(const Connection& aConnection, const std::string& aSql)
@@ -51,6 +105,43 @@ PreparedBulkStatementBinding::PreparedBulkStatementBinding(const Connection& aCo
 
 		parameterColumns.emplace_back("", parameterColumnType, true, 0, 0, 0, 0, 0);
 	}
+
+	std::string prefix;
+	std::string valuesList;
+	int bulkBatchRows = connection.getConnectionFactory().getSettings().bulkBatchRows;
+	/* buffered rows are registered at the handle context to flush them before other statements */
+	if(bulkBatchRows > 1 && parameterColumnsCount > 0 && connection.getHandleContext() && getValuesList(sql, prefix, valuesList)) {
+		int maxVariables = sqlite3_limit(&const_cast<sqlite3&>(connection.getConnectionHandle()), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+		batchRows = std::min(static_cast<std::size_t>(bulkBatchRows), static_cast<std::size_t>(maxVariables) / parameterColumnsCount);
+	}
+
+	if(batchRows > 1) {
+		batchSql = prefix + " " + valuesList;
+		for(std::size_t i = 1; i < batchRows; ++i) {
+			batchSql += ", " + valuesList;
+		}
+		batchSql += ";";
+
+		bufferedRows.resize(batchRows);
+		connection.addBulkStatementBinding(*this);
+	}
+	else {
+		batchRows = 1;
+	}
+}
+
+PreparedBulkStatementBinding::~PreparedBulkStatementBinding() {
+	if(batchRows > 1) {
+		try {
+			flush();
+		}
+		catch(const std::exception& e) {
+			logger.warn << "Cannot write buffered rows of bulk statement: " << e.what() << "\n";
+			connection.setBulkStatementError(e.what());
+		}
+		setBuffering(false);
+		connection.removeBulkStatementBinding(*this);
+	}
 }
 
 
@@ -59,20 +150,95 @@ const std::vector<esl::database::Column>& PreparedBulkStatementBinding::getParam
 }
 
 void PreparedBulkStatementBinding::execute(const std::vector<esl::database::Field>& parameterValues) {
+	if(parameterColumns.size() != parameterValues.size()) {
+	    throw esl::system::Stacktrace::add(std::runtime_error("Wrong number of arguments. Given " + std::to_string(parameterValues.size()) + " parameters but required " + std::to_string(parameterColumns.size()) + " parameters."));
+	}
+
+	/* without a transaction every row is committed immediately */
+	if(batchRows > 1 && sqlite3_get_autocommit(&const_cast<sqlite3&>(connection.getConnectionHandle())) == 0) {
+		bufferedRows[bufferedRowCount] = parameterValues;
+		++bufferedRowCount;
+		setBuffering(true);
+		if(bufferedRowCount == batchRows) {
+			flush();
+		}
+		return;
+	}
+
 	if(!statementHandle) {
 		logger.trace << "RE-Create statement handle\n";
 		statementHandle = connection.prepareSQLite(sql);
 	}
 
-	if(parameterColumns.size() != parameterValues.size()) {
-	    throw esl::system::Stacktrace::add(std::runtime_error("Wrong number of arguments. Given " + std::to_string(parameterValues.size()) + " parameters but required " + std::to_string(parameterColumns.size()) + " parameters."));
+	bind(statementHandle, 0, parameterValues);
+	step(statementHandle);
+}
+
+void PreparedBulkStatementBinding::flush() {
+	if(bufferedRowCount == 0) {
+		return;
+	}
+
+	/* buffered rows are dropped on error, the error is reported once */
+	std::size_t rowCount = bufferedRowCount;
+	bufferedRowCount = 0;
+	setBuffering(false);
+
+	if(rowCount == batchRows) {
+		if(!batchStatementHandle) {
+			batchStatementHandle = connection.prepareSQLite(batchSql);
+		}
+
+		for(std::size_t i = 0; i < rowCount; ++i) {
+			bind(batchStatementHandle, i * parameterColumns.size(), bufferedRows[i]);
+		}
+		step(batchStatementHandle);
 	}
+	else {
+		/* partial batch */
+		if(!statementHandle) {
+			logger.trace << "RE-Create statement handle\n";
+			statementHandle = connection.prepareSQLite(sql);
+		}
 
+		for(std::size_t i = 0; i < rowCount; ++i) {
+			bind(statementHandle, 0, bufferedRows[i]);
+			step(statementHandle);
+		}
+	}
+}
+
+void PreparedBulkStatementBinding::discard() noexcept {
+	bufferedRowCount = 0;
+	setBuffering(false);
+}
+
+void PreparedBulkStatementBinding::flush(HandleContext& handleContext) {
+	/* flush() unregisters the bulk statement before it steps its own statement */
+	while(!handleContext.bufferingBulkStatements.empty()) {
+		(*handleContext.bufferingBulkStatements.begin())->flush();
+	}
+}
+
+void PreparedBulkStatementBinding::setBuffering(bool buffering) {
+	HandleContext* handleContext = connection.getHandleContext();
+	if(handleContext == nullptr) {
+		return;
+	}
+	if(buffering) {
+		handleContext->bufferingBulkStatements.insert(this);
+	}
+	else {
+		handleContext->bufferingBulkStatements.erase(this);
+	}
+}
+
+void PreparedBulkStatementBinding::bind(const StatementHandle& targetStatementHandle, std::size_t offset, const std::vector<esl::database::Field>& parameterValues) const {
 	for(std::size_t i=0; i<parameterValues.size(); ++i) {
-		logger.debug << "Bind parameter[" << i << "]\n";
+		logger.debug << "Bind parameter[" << offset + i << "]\n";
 
 		if(parameterValues[i].isNull()) {
-			statementHandle.bindNull(i);
+			targetStatementHandle.bindNull(offset + i);
 		}
 		else {
 			switch(parameterColumns[i].getType()) {
@@ -82,7 +248,7 @@ void PreparedBulkStatementBinding::execute(const std::vector<esl::database::Fiel
 			case esl::database::Column::Type::sqlInteger:
 			case esl::database::Column::Type::sqlSmallInt:
 				logger.debug << "  USE field.asInteger\n";
-				statementHandle.bindInteger(i, parameterValues[i].asInteger());
+				targetStatementHandle.bindInteger(offset + i, parameterValues[i].asInteger());
 				break;
 
 			case esl::database::Column::Type::sqlDouble:
@@ -91,7 +257,7 @@ void PreparedBulkStatementBinding::execute(const std::vector<esl::database::Fiel
 			case esl::database::Column::Type::sqlFloat:
 			case esl::database::Column::Type::sqlReal:
 				logger.debug << "  USE field.asDouble\n";
-				statementHandle.bindDouble(i, parameterValues[i].asDouble());
+				targetStatementHandle.bindDouble(offset + i, parameterValues[i].asDouble());
 				break;
 
 			case esl::database::Column::Type::sqlVarChar:
@@ -101,7 +267,7 @@ void PreparedBulkStatementBinding::execute(const std::vector<esl::database::Fiel
 			case esl::database::Column::Type::sqlTime:
 			case esl::database::Column::Type::sqlTimestamp:
 				logger.debug << "  USE field.asString\n";
-				statementHandle.bindText(i, parameterValues[i].asString());
+				targetStatementHandle.bindText(offset + i, parameterValues[i].asString());
 				break;
 		/* ******************************** *
 		 * END: THIS WILL NEVER BE THE CASE *
@@ -113,21 +279,21 @@ void PreparedBulkStatementBinding::execute(const std::vector<esl::database::Fiel
 				case esl::database::Field::Type::storageBoolean:
 				case esl::database::Field::Type::storageInteger:
 					logger.debug << "  USE field.asInteger\n";
-					statementHandle.bindInteger(i, parameterValues[i].asInteger());
+					targetStatementHandle.bindInteger(offset + i, parameterValues[i].asInteger());
 					break;
 
 				case esl::database::Field::Type::storageDouble:
 					logger.debug << "  USE field.asDouble\n";
-					statementHandle.bindDouble(i, parameterValues[i].asDouble());
+					targetStatementHandle.bindDouble(offset + i, parameterValues[i].asDouble());
 					break;
 
 				case esl::database::Field::Type::storageString:
 					logger.debug << "  USE field.asString \"" << parameterValues[i].asString() << "\"\n";
-					statementHandle.bindText(i, parameterValues[i].asString());
+					targetStatementHandle.bindText(offset + i, parameterValues[i].asString());
 					break;
 
 				case esl::database::Field::Type::storageEmpty:
-					statementHandle.bindNull(i);
+					targetStatementHandle.bindNull(offset + i);
 					break;
 				}
 
@@ -135,13 +301,15 @@ void PreparedBulkStatementBinding::execute(const std::vector<esl::database::Fiel
 			}
 		}
 	}
+}
 
+void PreparedBulkStatementBinding::step(const StatementHandle& targetStatementHandle) const {
 	/* make a fetch and check, if there is a row available (e.g. no INSERT, UPDATE, DELETE) */
-	if(statementHandle.step()) {
+	if(targetStatementHandle.step()) {
 	    throw esl::system::Stacktrace::add(std::runtime_error("There is a row available, but this should be not the case for bulk statements."));
 	}
 
-	statementHandle.reset();
+	targetStatementHandle.reset();
 }
 
 void* PreparedBulkStatementBinding::getNativeHandle() const {
@@ -20,12 +20,14 @@
 #define SQLITE4ESL_DATABASE_PREPAREDBULKSTATEMENTBINDING_H_
 
 #include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/HandleContext.h>
 #include <sqlite4esl/database/StatementHandle.h>
 
 #include <esl/database/PreparedBulkStatement.h>
 #include <esl/database/Column.h>
 #include <esl/database/Field.h>
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -36,16 +38,37 @@ namespace database {
 class PreparedBulkStatementBinding : public esl::database::PreparedBulkStatement::Binding {
 public:
 	PreparedBulkStatementBinding(const Connection& connection, const std::string& sql);
+	~PreparedBulkStatementBinding();
 
 	const std::vector<esl::database::Column>& getParameterColumns() const override;
 	void execute(const std::vector<esl::database::Field>& fields) override;
 	void* getNativeHandle() const override;
 
+	/* Writes rows buffered for a multi-row INSERT */
+	void flush();
+	/* Drops rows buffered for a multi-row INSERT */
+	void discard() noexcept;
+
+	/* Writes the buffered rows of all bulk statements of the handle, called before a
+	 * statement is stepped */
+	static void flush(HandleContext& handleContext);
+
 private:
+	void bind(const StatementHandle& targetStatementHandle, std::size_t offset, const std::vector<esl::database::Field>& parameterValues) const;
+	void step(const StatementHandle& targetStatementHandle) const;
+	void setBuffering(bool buffering);
+
 	const Connection& connection;
 	std::string sql;
 	StatementHandle statementHandle;
 	std::vector<esl::database::Column> parameterColumns;
+
+	/* Multi-row variant "INSERT ... VALUES (?, ...), (?, ...), ..." of "sql" */
+	std::string batchSql;
+	StatementHandle batchStatementHandle;
+	std::size_t batchRows = 1;
+	std::vector<std::vector<esl::database::Field>> bufferedRows;
+	std::size_t bufferedRowCount = 0;
 };
 
 } /* namespace database */
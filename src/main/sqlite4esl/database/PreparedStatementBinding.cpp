@@ -17,6 +17,8 @@
  */
 
 #include <sqlite4esl/database/PreparedStatementBinding.h>
+#include <sqlite4esl/database/CachedResultSetBinding.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
 #include <sqlite4esl/database/ResultSetBinding.h>
 
 #include <esl/Logger.h>
@@ -55,6 +57,11 @@ PreparedStatementBinding::PreparedStatementBinding(const Connection& aConnection
 
 		parameterColumns.emplace_back("", parameterColumnType, true, 0, 0, 0, 0, 0);
 	}
+
+	ResultCache* resultCache = connection.getConnectionFactory().getResultCache();
+	if(resultCache && sqlite3_stmt_readonly(&statementHandle.getHandle())) {
+		resultCacheDependencies = resultCache->getDependencies(const_cast<sqlite3&>(connection.getConnectionHandle()), sql);
+	}
 }
 
 const std::vector<esl::database::Column>& PreparedStatementBinding::getParameterColumns() const {
@@ -75,6 +82,20 @@ esl::database::ResultSet PreparedStatementBinding::execute(const std::vector<esl
 	    throw esl::system::Stacktrace::add(std::runtime_error("Wrong number of arguments. Given " + std::to_string(parameterValues.size()) + " parameters but required " + std::to_string(parameterColumns.size()) + " parameters."));
 	}
 
+	/* inside of a transaction the handle may read its own uncommitted changes */
+	std::string resultCacheKey;
+	if(resultCacheDependencies && resultCacheDependencies->cacheable
+			&& sqlite3_get_autocommit(const_cast<sqlite3*>(&connection.getConnectionHandle())) != 0) {
+		resultCacheKey = ResultCache::makeKey(sql, parameterValues);
+		std::shared_ptr<const ResultCache::Result> result = connection.getConnectionFactory().getResultCache()->get(resultCacheKey);
+		if(result) {
+			if(result->rows.empty()) {
+				return esl::database::ResultSet();
+			}
+			return esl::database::ResultSet(std::unique_ptr<esl::database::ResultSet::Binding>(new CachedResultSetBinding(std::move(result), resultColumns)));
+		}
+	}
+
 	for(std::size_t i=0; i<parameterValues.size(); ++i) {
 		logger.debug << "Bind parameter[" << i << "]\n";
 
@@ -143,6 +164,10 @@ esl::database::ResultSet PreparedStatementBinding::execute(const std::vector<esl
 		}
 	}
 
+	if(!resultCacheKey.empty()) {
+		return executeCached(*connection.getConnectionFactory().getResultCache(), resultCacheKey);
+	}
+
 	esl::database::ResultSet resultSet;
 
 	/* ResultSetBinding makes the "execute" */
@@ -159,6 +184,33 @@ esl::database::ResultSet PreparedStatementBinding::execute(const std::vector<esl
 	return resultSet;
 }
 
+esl::database::ResultSet PreparedStatementBinding::executeCached(ResultCache& resultCache, const std::string& key) {
+	std::uint64_t generation = resultCache.getGeneration();
+	std::shared_ptr<ResultCache::Result> result = std::make_shared<ResultCache::Result>();
+
+	if(!statementHandle.step()) {
+		statementHandle.reset();
+		resultCache.put(key, resultCacheDependencies, std::move(result), generation);
+		return esl::database::ResultSet();
+	}
+
+	std::unique_ptr<ResultSetBinding> resultSetBinding(new ResultSetBinding(std::move(statementHandle), resultColumns));
+	std::vector<esl::database::Field> fields(resultColumns.size());
+	while(resultSetBinding->fetch(fields)) {
+		result->size += ResultCache::getSize(fields);
+		result->rows.push_back(fields);
+
+		if(result->size > resultCache.getMaxResultSize()) {
+			/* too large to be cached, the remaining rows are fetched from the statement */
+			return esl::database::ResultSet(std::unique_ptr<esl::database::ResultSet::Binding>(new CachedResultSetBinding(std::move(result), resultColumns, std::move(resultSetBinding))));
+		}
+	}
+	resultSetBinding.reset();
+
+	resultCache.put(key, resultCacheDependencies, result, generation);
+	return esl::database::ResultSet(std::unique_ptr<esl::database::ResultSet::Binding>(new CachedResultSetBinding(std::move(result), resultColumns)));
+}
+
 void* PreparedStatementBinding::getNativeHandle() const {
 	if(statementHandle) {
 		return &statementHandle.getHandle();
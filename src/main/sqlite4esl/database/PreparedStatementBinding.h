@@ -20,6 +20,7 @@
 #define SQLITE4ESL_DATABASE_PREPAREDSTATEMENTBINDING_H_
 
 #include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ResultCache.h>
 #include <sqlite4esl/database/StatementHandle.h>
 
 #include <esl/database/Column.h>
@@ -27,6 +28,7 @@
 #include <esl/database/ResultSet.h>
 #include <esl/database/PreparedStatement.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -45,11 +47,15 @@ public:
 	void* getNativeHandle() const override;
 
 private:
+	esl::database::ResultSet executeCached(ResultCache& resultCache, const std::string& key);
+
 	const Connection& connection;
 	std::string sql;
 	StatementHandle statementHandle;
 	std::vector<esl::database::Column> parameterColumns;
 	std::vector<esl::database::Column> resultColumns;
+	/* nullptr if the result cache is disabled */
+	std::shared_ptr<const ResultCache::Dependencies> resultCacheDependencies;
 };
 
 } /* namespace database */
@@ -0,0 +1,175 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/QueryPlanRecorder.h>
+
+#include <esl/Logger.h>
+
+#include <utility>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::QueryPlanRecorder");
+}
+
+QueryPlan::QueryPlan(QueryPlanRecorder& aRecorder, std::string aSql, std::string aPlan)
+: recorder(aRecorder),
+  sql(std::move(aSql)),
+  plan(std::move(aPlan))
+{ }
+
+void QueryPlan::collect(sqlite3_stmt& statementHandle) {
+	std::uint64_t currentVmSteps = static_cast<std::uint64_t>(sqlite3_stmt_status(&statementHandle, SQLITE_STMTSTATUS_VM_STEP, 1));
+	std::uint64_t currentFullScanSteps = static_cast<std::uint64_t>(sqlite3_stmt_status(&statementHandle, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1));
+	std::uint64_t currentAutoIndexRows = static_cast<std::uint64_t>(sqlite3_stmt_status(&statementHandle, SQLITE_STMTSTATUS_AUTOINDEX, 1));
+
+	if(currentVmSteps == 0) {
+		/* statement has not been executed since last collect */
+		return;
+	}
+
+	executions.fetch_add(1, std::memory_order_relaxed);
+	vmSteps.fetch_add(currentVmSteps, std::memory_order_relaxed);
+	fullScanSteps.fetch_add(currentFullScanSteps, std::memory_order_relaxed);
+	autoIndexRows.fetch_add(currentAutoIndexRows, std::memory_order_relaxed);
+	updateMax(maxFullScanSteps, currentFullScanSteps);
+	updateMax(maxAutoIndexRows, currentAutoIndexRows);
+
+	if(recorder.isFlagged(currentFullScanSteps, currentAutoIndexRows) && !flagged.exchange(true)) {
+		logger.warn << "Statement did " << currentFullScanSteps << " full scan steps and inserted " << currentAutoIndexRows << " rows into automatic indexes: \"" << sql << "\"\n";
+		logger.warn << "Query plan:\n" << plan;
+	}
+}
+
+QueryPlan::Report QueryPlan::getReport() const {
+	Report report;
+
+	report.sql = sql;
+	report.plan = plan;
+	report.executions = executions.load(std::memory_order_relaxed);
+	report.vmSteps = vmSteps.load(std::memory_order_relaxed);
+	report.fullScanSteps = fullScanSteps.load(std::memory_order_relaxed);
+	report.autoIndexRows = autoIndexRows.load(std::memory_order_relaxed);
+	report.maxFullScanSteps = maxFullScanSteps.load(std::memory_order_relaxed);
+	report.maxAutoIndexRows = maxAutoIndexRows.load(std::memory_order_relaxed);
+
+	return report;
+}
+
+void QueryPlan::updateMax(std::atomic<std::uint64_t>& max, std::uint64_t value) {
+	std::uint64_t current = max.load(std::memory_order_relaxed);
+	while(current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+QueryPlanRecorder::QueryPlanRecorder(std::uint64_t aFullScanThreshold, std::uint64_t aAutoIndexThreshold, std::size_t aMaxStatements)
+: fullScanThreshold(aFullScanThreshold),
+  autoIndexThreshold(aAutoIndexThreshold),
+  maxStatements(aMaxStatements)
+{ }
+
+QueryPlan* QueryPlanRecorder::get(sqlite3& connectionHandle, const std::string& sql) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto iter = queryPlans.find(sql);
+		if(iter != queryPlans.end()) {
+			return iter->second.get();
+		}
+		if(maxStatements > 0 && queryPlans.size() >= maxStatements) {
+			return nullptr;
+		}
+	}
+
+	/* explain without holding the lock, another thread might record the same SQL meanwhile */
+	std::string plan = explain(connectionHandle, sql);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto iter = queryPlans.find(sql);
+	if(iter != queryPlans.end()) {
+		return iter->second.get();
+	}
+	if(maxStatements > 0 && queryPlans.size() >= maxStatements) {
+		return nullptr;
+	}
+
+	std::unique_ptr<QueryPlan>& queryPlan = queryPlans[sql];
+	queryPlan.reset(new QueryPlan(*this, sql, std::move(plan)));
+	return queryPlan.get();
+}
+
+bool QueryPlanRecorder::isFlagged(std::uint64_t fullScanSteps, std::uint64_t autoIndexRows) const noexcept {
+	return (fullScanThreshold > 0 && fullScanSteps >= fullScanThreshold) || (autoIndexThreshold > 0 && autoIndexRows >= autoIndexThreshold);
+}
+
+std::vector<QueryPlan::Report> QueryPlanRecorder::getReport(std::uint64_t fullScanThreshold, std::uint64_t autoIndexThreshold) const {
+	std::vector<QueryPlan::Report> reports;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for(const auto& queryPlan : queryPlans) {
+		QueryPlan::Report report = queryPlan.second->getReport();
+		if((fullScanThreshold > 0 && report.maxFullScanSteps >= fullScanThreshold) || (autoIndexThreshold > 0 && report.maxAutoIndexRows >= autoIndexThreshold)) {
+			reports.push_back(std::move(report));
+		}
+	}
+
+	return reports;
+}
+
+std::vector<QueryPlan::Report> QueryPlanRecorder::getReport() const {
+	return getReport(fullScanThreshold, autoIndexThreshold);
+}
+
+std::string QueryPlanRecorder::explain(sqlite3& connectionHandle, const std::string& sql) {
+	std::string explainSql = "EXPLAIN QUERY PLAN " + sql;
+	sqlite3_stmt* stmt = nullptr;
+
+	int rc = sqlite3_prepare_v2(&connectionHandle, explainSql.c_str(), static_cast<int>(explainSql.length() + 1), &stmt, nullptr);
+	if(rc != SQLITE_OK) {
+		logger.debug << "Can't explain SQL statement \"" << sql << "\": " << sqlite3_errmsg(&connectionHandle) << "\n";
+		sqlite3_finalize(stmt);
+		return "";
+	}
+
+	/* rows are (id, parent, notused, detail), children follow their parent */
+	std::string plan;
+	std::map<int, std::size_t> depths;
+	while((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		int id = sqlite3_column_int(stmt, 0);
+		int parent = sqlite3_column_int(stmt, 1);
+		const char* detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+
+		auto parentIter = depths.find(parent);
+		std::size_t depth = parentIter == depths.end() ? 0 : parentIter->second + 1;
+		depths[id] = depth;
+
+		plan += std::string(2 * depth, ' ') + (detail ? detail : "") + "\n";
+	}
+	if(rc != SQLITE_DONE) {
+		logger.debug << "Can't explain SQL statement \"" << sql << "\": " << sqlite3_errmsg(&connectionHandle) << "\n";
+	}
+	sqlite3_finalize(stmt);
+
+	return plan;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
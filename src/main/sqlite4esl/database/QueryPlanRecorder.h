@@ -0,0 +1,107 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_QUERYPLANRECORDER_H_
+#define SQLITE4ESL_DATABASE_QUERYPLANRECORDER_H_
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+class QueryPlanRecorder;
+
+/* Plan and execution counters of one distinct SQL statement */
+class QueryPlan {
+public:
+	struct Report {
+		std::string sql;
+		std::string plan;
+		std::uint64_t executions;
+		std::uint64_t vmSteps;
+		std::uint64_t fullScanSteps;
+		std::uint64_t autoIndexRows;
+		std::uint64_t maxFullScanSteps;
+		std::uint64_t maxAutoIndexRows;
+	};
+
+	QueryPlan(QueryPlanRecorder& recorder, std::string sql, std::string plan);
+
+	/* Called when a statement handle completes an execution, reads and resets its counters */
+	void collect(sqlite3_stmt& statementHandle);
+
+	Report getReport() const;
+
+private:
+	void updateMax(std::atomic<std::uint64_t>& max, std::uint64_t value);
+
+	QueryPlanRecorder& recorder;
+	const std::string sql;
+	const std::string plan;
+
+	std::atomic<std::uint64_t> executions{0};
+	std::atomic<std::uint64_t> vmSteps{0};
+	std::atomic<std::uint64_t> fullScanSteps{0};
+	std::atomic<std::uint64_t> autoIndexRows{0};
+	std::atomic<std::uint64_t> maxFullScanSteps{0};
+	std::atomic<std::uint64_t> maxAutoIndexRows{0};
+	std::atomic<bool> flagged{false};
+};
+
+class QueryPlanRecorder {
+public:
+	/* "maxStatements" limits the number of distinct SQL recorded, 0 for no limit */
+	QueryPlanRecorder(std::uint64_t fullScanThreshold, std::uint64_t autoIndexThreshold, std::size_t maxStatements);
+
+	/* Returns the query plan of "sql". EXPLAIN QUERY PLAN is run on "connectionHandle"
+	 * only the first time a SQL is seen. Returns nullptr for new SQL once "maxStatements"
+	 * are recorded. Plans are never evicted, statement handles keep pointers to them. */
+	QueryPlan* get(sqlite3& connectionHandle, const std::string& sql);
+
+	bool isFlagged(std::uint64_t fullScanSteps, std::uint64_t autoIndexRows) const noexcept;
+
+	/* Statements with a single execution at or above one of the given thresholds */
+	std::vector<QueryPlan::Report> getReport(std::uint64_t fullScanThreshold, std::uint64_t autoIndexThreshold) const;
+	std::vector<QueryPlan::Report> getReport() const;
+
+private:
+	static std::string explain(sqlite3& connectionHandle, const std::string& sql);
+
+	const std::uint64_t fullScanThreshold;
+	const std::uint64_t autoIndexThreshold;
+	const std::size_t maxStatements;
+
+	mutable std::mutex mutex;
+	std::map<std::string, std::unique_ptr<QueryPlan>> queryPlans;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_QUERYPLANRECORDER_H_ */
@@ -0,0 +1,479 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/ResultCache.h>
+#include <sqlite4esl/database/ChangeCapture.h>
+
+#include <esl/Logger.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::ResultCache");
+
+/* built-in functions whose result is not determined by the data */
+const char* nonDeterministicFunctions[] = {
+	"random", "randomblob", "changes", "total_changes", "last_insert_rowid",
+	"date", "time", "datetime", "julianday", "unixepoch", "strftime", "timediff",
+	"current_date", "current_time", "current_timestamp"
+};
+
+struct Authorization {
+	bool cacheable = true;
+	std::vector<std::pair<std::string, std::string>> tables;
+};
+
+int authorize(void* authorizationPtr, int action, const char* arg1, const char* arg2, const char* database, const char*) {
+	Authorization& authorization = *static_cast<Authorization*>(authorizationPtr);
+
+	if(action == SQLITE_READ && arg1) {
+		/* the database is not given for tables read without columns, e.g. count(*) */
+		std::pair<std::string, std::string> table(database ? database : "", arg1);
+		if(std::find(authorization.tables.begin(), authorization.tables.end(), table) == authorization.tables.end()) {
+			authorization.tables.push_back(std::move(table));
+		}
+	}
+	else if(action == SQLITE_FUNCTION && arg2) {
+		for(const char* function : nonDeterministicFunctions) {
+			if(sqlite3_stricmp(function, arg2) == 0) {
+				authorization.cacheable = false;
+				break;
+			}
+		}
+	}
+	else if(action == SQLITE_PRAGMA || action == SQLITE_ATTACH || action == SQLITE_DETACH) {
+		authorization.cacheable = false;
+	}
+
+	return SQLITE_OK;
+}
+
+enum class TableKind {
+	unknown,
+	ordinary,
+	view,
+	other
+};
+
+/* Table options follow the closing parenthesis of the column definitions */
+bool isWithoutRowid(const char* tableSql) {
+	const char* options = std::strrchr(tableSql, ')');
+	if(options == nullptr) {
+		return false;
+	}
+	for(; *options != 0; ++options) {
+		if(sqlite3_strnicmp(options, "WITHOUT", 7) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string getSchemaTable(const std::string& database) {
+	std::string schemaTable = "\"";
+	for(char c : database) {
+		if(c == '"') {
+			schemaTable += '"';
+		}
+		schemaTable += c;
+	}
+	schemaTable += "\".sqlite_master";
+	return schemaTable;
+}
+
+/* Only ordinary tables are changed by committed transactions that are seen by the update
+ * hook. The update hook is not called for WITHOUT ROWID tables. */
+TableKind getTableKind(sqlite3& connectionHandle, const std::string& database, const std::string& table) {
+	if(table.compare(0, 7, "sqlite_") == 0) {
+		return TableKind::other;
+	}
+
+	std::string sql = "SELECT type, sql FROM " + getSchemaTable(database) + " WHERE type IN ('table', 'view') AND name = ?";
+
+	sqlite3_stmt* stmt = nullptr;
+	if(sqlite3_prepare_v2(&connectionHandle, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+		sqlite3_finalize(stmt);
+		return TableKind::other;
+	}
+
+	TableKind tableKind = TableKind::unknown;
+	sqlite3_bind_text(stmt, 1, table.c_str(), static_cast<int>(table.size()), SQLITE_TRANSIENT);
+	if(sqlite3_step(stmt) == SQLITE_ROW) {
+		const char* type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+		const char* tableSql = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+		if(type && std::strcmp(type, "view") == 0) {
+			tableKind = TableKind::view;
+		}
+		else if(tableSql && sqlite3_strnicmp(tableSql, "CREATE VIRTUAL", 14) != 0 && !isWithoutRowid(tableSql)) {
+			tableKind = TableKind::ordinary;
+		}
+		else {
+			tableKind = TableKind::other;
+		}
+	}
+	sqlite3_finalize(stmt);
+
+	return tableKind;
+}
+
+/* Databases in the order unqualified table names are resolved */
+std::vector<std::string> getDatabases(sqlite3& connectionHandle) {
+	std::vector<std::string> databases{"temp", "main"};
+
+	sqlite3_stmt* stmt = nullptr;
+	if(sqlite3_prepare_v2(&connectionHandle, "PRAGMA database_list", -1, &stmt, nullptr) == SQLITE_OK) {
+		while(sqlite3_step(stmt) == SQLITE_ROW) {
+			const char* database = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+			if(database && std::strcmp(database, "temp") != 0 && std::strcmp(database, "main") != 0) {
+				databases.push_back(database);
+			}
+		}
+	}
+	sqlite3_finalize(stmt);
+
+	return databases;
+}
+
+/* The authorizer does not report tables that are only read by the join constraint of
+ * USING or NATURAL, so the tables of all b-trees opened by the bytecode are added.
+ * Returns false if a b-tree does not belong to a table of a schema. */
+bool addOpenedTables(sqlite3& connectionHandle, const std::string& sql, std::vector<std::pair<std::string, std::string>>& tables) {
+	/* database index and root page */
+	std::vector<std::pair<int, int>> rootPages;
+
+	sqlite3_stmt* stmt = nullptr;
+	std::string explainSql = "EXPLAIN " + sql;
+	if(sqlite3_prepare_v2(&connectionHandle, explainSql.c_str(), static_cast<int>(explainSql.size()), &stmt, nullptr) != SQLITE_OK) {
+		sqlite3_finalize(stmt);
+		return false;
+	}
+	bool opensVirtualTable = false;
+	while(sqlite3_step(stmt) == SQLITE_ROW) {
+		/* columns are addr, opcode, p1, p2, p3, ... */
+		const char* opcode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+		if(opcode == nullptr) {
+			continue;
+		}
+		if(std::strcmp(opcode, "OpenRead") == 0 || std::strcmp(opcode, "ReopenIdx") == 0) {
+			rootPages.emplace_back(sqlite3_column_int(stmt, 4), sqlite3_column_int(stmt, 3));
+		}
+		else if(std::strcmp(opcode, "VOpen") == 0) {
+			opensVirtualTable = true;
+		}
+	}
+	sqlite3_finalize(stmt);
+	if(opensVirtualTable) {
+		return false;
+	}
+
+	std::map<int, std::string> databases;
+	if(sqlite3_prepare_v2(&connectionHandle, "PRAGMA database_list", -1, &stmt, nullptr) == SQLITE_OK) {
+		while(sqlite3_step(stmt) == SQLITE_ROW) {
+			const char* database = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+			databases[sqlite3_column_int(stmt, 0)] = database ? database : "";
+		}
+	}
+	sqlite3_finalize(stmt);
+
+	for(const auto& rootPage : rootPages) {
+		auto database = databases.find(rootPage.first);
+		if(database == databases.end()) {
+			return false;
+		}
+
+		std::string tableSql = "SELECT tbl_name FROM " + getSchemaTable(database->second) + " WHERE type IN ('table', 'index') AND rootpage = ?";
+		if(sqlite3_prepare_v2(&connectionHandle, tableSql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+			sqlite3_finalize(stmt);
+			return false;
+		}
+		sqlite3_bind_int(stmt, 1, rootPage.second);
+		const char* tableName = sqlite3_step(stmt) == SQLITE_ROW ? reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)) : nullptr;
+		if(tableName == nullptr) {
+			/* e.g. the schema table itself */
+			sqlite3_finalize(stmt);
+			return false;
+		}
+
+		std::pair<std::string, std::string> table(database->second, tableName);
+		sqlite3_finalize(stmt);
+		if(std::find(tables.begin(), tables.end(), table) == tables.end()) {
+			tables.push_back(std::move(table));
+		}
+	}
+
+	return true;
+}
+
+void appendBytes(std::string& key, const void* data, std::size_t size) {
+	key.append(static_cast<const char*>(data), size);
+}
+}
+
+ResultCache::ResultCache(std::size_t aCapacity)
+: capacity(aCapacity)
+{ }
+
+std::size_t ResultCache::getMaxResultSize() const noexcept {
+	/* a single result must not displace most of the cache */
+	return capacity / 8;
+}
+
+std::shared_ptr<const ResultCache::Dependencies> ResultCache::getDependencies(sqlite3& connectionHandle, const std::string& sql) {
+	{
+		std::lock_guard<std::mutex> lock(dependenciesMutex);
+		auto iter = dependenciesBySql.find(sql);
+		if(iter != dependenciesBySql.end()) {
+			return iter->second;
+		}
+	}
+
+	/* The authorizer is called while the statement is compiled. Setting the authorizer
+	 * expires the prepared statements of the handle, so this is done once per SQL.
+	 * Handles of a factory with a result cache always have a change recorder, whose
+	 * authorizer is installed again afterwards. */
+	Authorization authorization;
+	sqlite3_set_authorizer(&connectionHandle, authorize, &authorization);
+	sqlite3_stmt* stmt = nullptr;
+	int rc = sqlite3_prepare_v2(&connectionHandle, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+	sqlite3_set_authorizer(&connectionHandle, ChangeCapture::Recorder::authorize, nullptr);
+
+	std::shared_ptr<Dependencies> dependencies = std::make_shared<Dependencies>();
+	dependencies->cacheable = rc == SQLITE_OK && stmt && sqlite3_stmt_readonly(stmt) && authorization.cacheable;
+	sqlite3_finalize(stmt);
+	if(dependencies->cacheable) {
+		dependencies->cacheable = addOpenedTables(connectionHandle, sql, authorization.tables);
+	}
+
+	std::vector<std::string> databases;
+	for(const auto& table : authorization.tables) {
+		if(!dependencies->cacheable) {
+			break;
+		}
+
+		std::string database = table.first;
+		TableKind tableKind = TableKind::unknown;
+		if(database.empty()) {
+			if(databases.empty()) {
+				databases = getDatabases(connectionHandle);
+			}
+			for(const auto& candidate : databases) {
+				tableKind = getTableKind(connectionHandle, candidate, table.second);
+				if(tableKind != TableKind::unknown) {
+					database = candidate;
+					break;
+				}
+			}
+		}
+		else {
+			tableKind = getTableKind(connectionHandle, database, table.second);
+		}
+
+		if(tableKind == TableKind::view) {
+			/* the tables of a view are reported as well */
+			continue;
+		}
+
+		/* temp tables are private to one handle */
+		dependencies->cacheable = tableKind == TableKind::ordinary && database != "temp";
+
+		std::string qualifiedTable = database + "." + table.second;
+		if(std::find(dependencies->tables.begin(), dependencies->tables.end(), qualifiedTable) == dependencies->tables.end()) {
+			dependencies->tables.push_back(std::move(qualifiedTable));
+		}
+	}
+
+	if(!dependencies->cacheable) {
+		logger.debug << "Results of SQL \"" << sql << "\" are not cached\n";
+		dependencies->tables.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(dependenciesMutex);
+	return dependenciesBySql.emplace(sql, std::move(dependencies)).first->second;
+}
+
+std::string ResultCache::makeKey(const std::string& sql, const std::vector<esl::database::Field>& parameterValues) {
+	std::string key = sql;
+	key += '\0';
+
+	for(const auto& parameterValue : parameterValues) {
+		if(parameterValue.isNull()) {
+			key += 'n';
+			continue;
+		}
+
+		switch(parameterValue.getSimpleType()) {
+		case esl::database::Field::Type::storageBoolean:
+		case esl::database::Field::Type::storageInteger: {
+			std::int64_t value = parameterValue.asInteger();
+			key += 'i';
+			appendBytes(key, &value, sizeof(value));
+			break;
+		}
+		case esl::database::Field::Type::storageDouble: {
+			double value = parameterValue.asDouble();
+			key += 'd';
+			appendBytes(key, &value, sizeof(value));
+			break;
+		}
+		case esl::database::Field::Type::storageString: {
+			std::string value = parameterValue.asString();
+			std::uint64_t size = value.size();
+			key += 's';
+			appendBytes(key, &size, sizeof(size));
+			key += value;
+			break;
+		}
+		case esl::database::Field::Type::storageEmpty:
+		default:
+			key += 'n';
+			break;
+		}
+	}
+
+	return key;
+}
+
+std::size_t ResultCache::getSize(const Row& row) {
+	std::size_t size = sizeof(Row) + row.size() * sizeof(esl::database::Field);
+	for(const auto& field : row) {
+		if(!field.isNull() && field.getSimpleType() == esl::database::Field::Type::storageString) {
+			size += field.asString().size();
+		}
+	}
+	return size;
+}
+
+std::shared_ptr<const ResultCache::Result> ResultCache::get(const std::string& key) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto iter = entriesByKey.find(key);
+	if(iter == entriesByKey.end()) {
+		++statistics.misses;
+		return nullptr;
+	}
+
+	++statistics.hits;
+	entries.splice(entries.begin(), entries, iter->second);
+	return iter->second->result;
+}
+
+std::uint64_t ResultCache::getGeneration() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return generation;
+}
+
+void ResultCache::put(const std::string& key, std::shared_ptr<const Dependencies> dependencies, std::shared_ptr<const Result> result, std::uint64_t resultGeneration) {
+	std::size_t entrySize = result->size + key.size() + sizeof(Entry);
+	if(entrySize > getMaxResultSize()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if(clearGeneration > resultGeneration) {
+		return;
+	}
+	for(const auto& table : dependencies->tables) {
+		auto iter = tableGenerations.find(table);
+		if(iter != tableGenerations.end() && iter->second > resultGeneration) {
+			/* a transaction has written to the table while the result was read */
+			return;
+		}
+	}
+
+	auto iter = entriesByKey.find(key);
+	if(iter != entriesByKey.end()) {
+		erase(iter->second);
+	}
+
+	while(!entries.empty() && statistics.size + entrySize > capacity) {
+		erase(std::prev(entries.end()));
+		++statistics.evictions;
+	}
+
+	entries.push_front(Entry{key, std::move(dependencies), std::move(result)});
+	entriesByKey.emplace(key, entries.begin());
+	statistics.size += entrySize;
+	++statistics.entries;
+	++statistics.insertions;
+}
+
+void ResultCache::invalidate(const std::vector<std::string>& tables) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	++generation;
+	for(const auto& table : tables) {
+		tableGenerations[table] = generation;
+	}
+
+	for(auto iter = entries.begin(); iter != entries.end();) {
+		const std::vector<std::string>& entryTables = iter->dependencies->tables;
+		bool invalid = false;
+		for(const auto& table : tables) {
+			if(std::find(entryTables.begin(), entryTables.end(), table) != entryTables.end()) {
+				invalid = true;
+				break;
+			}
+		}
+
+		auto current = iter++;
+		if(invalid) {
+			erase(current);
+			++statistics.invalidations;
+		}
+	}
+}
+
+void ResultCache::clear() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		clearGeneration = ++generation;
+		statistics.invalidations += entries.size();
+		entries.clear();
+		entriesByKey.clear();
+		statistics.entries = 0;
+		statistics.size = 0;
+	}
+
+	std::lock_guard<std::mutex> lock(dependenciesMutex);
+	dependenciesBySql.clear();
+}
+
+ResultCache::Statistics ResultCache::getStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+void ResultCache::erase(std::list<Entry>::iterator iter) {
+	statistics.size -= iter->result->size + iter->key.size() + sizeof(Entry);
+	--statistics.entries;
+	entriesByKey.erase(iter->key);
+	entries.erase(iter);
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,123 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_RESULTCACHE_H_
+#define SQLITE4ESL_DATABASE_RESULTCACHE_H_
+
+#include <esl/database/Field.h>
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Materialized results of read only statements, keyed by SQL and parameter values.
+ * Entries are invalidated when a transaction that wrote to one of their tables is
+ * committed on a handle of the same connection factory. Writes of other processes or
+ * other factories and schema changes are not seen, call clear() in these cases.
+ * Statements calling built-in non deterministic functions (random(), datetime(), ...)
+ * are not cached, but user defined functions are assumed to be deterministic. */
+class ResultCache {
+public:
+	using Row = std::vector<esl::database::Field>;
+
+	struct Result {
+		std::vector<Row> rows;
+		std::size_t size = 0;
+	};
+
+	/* Tables read by a statement as "<database>.<table>" */
+	struct Dependencies {
+		bool cacheable = false;
+		std::vector<std::string> tables;
+	};
+
+	struct Statistics {
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t insertions = 0;
+		std::uint64_t evictions = 0;
+		std::uint64_t invalidations = 0;
+		std::size_t entries = 0;
+		std::size_t size = 0;
+	};
+
+	ResultCache(std::size_t capacity);
+
+	/* Results larger than this are not cached */
+	std::size_t getMaxResultSize() const noexcept;
+
+	/* Statements that read temp tables, virtual tables, WITHOUT ROWID tables or the schema
+	 * are not cacheable */
+	std::shared_ptr<const Dependencies> getDependencies(sqlite3& connectionHandle, const std::string& sql);
+
+	static std::string makeKey(const std::string& sql, const std::vector<esl::database::Field>& parameterValues);
+	static std::size_t getSize(const Row& row);
+
+	std::shared_ptr<const Result> get(const std::string& key);
+
+	/* Returns a generation that has to be given to put() for a result computed afterwards */
+	std::uint64_t getGeneration() const;
+	/* The result is dropped if one of its tables has been invalidated after "generation" */
+	void put(const std::string& key, std::shared_ptr<const Dependencies> dependencies, std::shared_ptr<const Result> result, std::uint64_t generation);
+
+	void invalidate(const std::vector<std::string>& tables);
+	void clear();
+
+	Statistics getStatistics() const;
+
+private:
+	struct Entry {
+		std::string key;
+		std::shared_ptr<const Dependencies> dependencies;
+		std::shared_ptr<const Result> result;
+	};
+
+	void erase(std::list<Entry>::iterator iter);
+
+	const std::size_t capacity;
+
+	mutable std::mutex mutex;
+	/* most recently used first */
+	std::list<Entry> entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> entriesByKey;
+	std::map<std::string, std::uint64_t> tableGenerations;
+	std::uint64_t generation = 0;
+	std::uint64_t clearGeneration = 0;
+	Statistics statistics;
+
+	std::mutex dependenciesMutex;
+	std::unordered_map<std::string, std::shared_ptr<const Dependencies>> dependenciesBySql;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_RESULTCACHE_H_ */
@@ -49,40 +49,7 @@ bool ResultSetBinding::fetch(std::vector<esl::database::Field>& fields) {
 		return false;
 	}
 
-	for(std::size_t i=0; i<getColumns().size(); ++i) {
-		/* check if column value was NULL */
-		if(statementHandle.columnValueIsNull(i)) {
-			fields[i] = nullptr;
-			continue;
-		}
-
-		switch(statementHandle.columnType(i)) {
-		case esl::database::Column::Type::sqlInteger:
-		case esl::database::Column::Type::sqlSmallInt:
-			logger.debug << "Set integer\n";
-			fields[i] = statementHandle.columnInteger(i);
-			logger.debug << "Set integer done\n";
-			break;
-
-		case esl::database::Column::Type::sqlDouble:
-		case esl::database::Column::Type::sqlNumeric:
-		case esl::database::Column::Type::sqlDecimal:
-		case esl::database::Column::Type::sqlFloat:
-		case esl::database::Column::Type::sqlReal:
-			logger.debug << "Set double\n";
-			fields[i] = statementHandle.columnDouble(i);
-			logger.debug << "Set double done\n";
-			break;
-
-		case esl::database::Column::Type::sqlVarChar:
-		case esl::database::Column::Type::sqlChar:
-		default:
-			logger.debug << "Set string\n";
-			fields[i] = statementHandle.columnText(i);
-			logger.debug << "Set string done\n";
-			break;
-		}
-	}
+	statementHandle.columns(fields);
 
 	return true;
 }
@@ -0,0 +1,110 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/RetryPolicy.h>
+
+#include <esl/Logger.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::RetryPolicy");
+}
+
+RetryPolicy& RetryPolicy::setMaxAttempts(unsigned int aMaxAttempts) noexcept {
+	maxAttempts = aMaxAttempts;
+	return *this;
+}
+
+RetryPolicy& RetryPolicy::setInitialBackoff(std::chrono::milliseconds aInitialBackoff) noexcept {
+	initialBackoff = aInitialBackoff;
+	return *this;
+}
+
+RetryPolicy& RetryPolicy::setMaxBackoff(std::chrono::milliseconds aMaxBackoff) noexcept {
+	maxBackoff = aMaxBackoff;
+	return *this;
+}
+
+RetryPolicy& RetryPolicy::setBackoffMultiplier(double aBackoffMultiplier) noexcept {
+	backoffMultiplier = aBackoffMultiplier;
+	return *this;
+}
+
+RetryPolicy& RetryPolicy::setBeginStatement(std::string aBeginStatement) {
+	beginStatement = std::move(aBeginStatement);
+	return *this;
+}
+
+RetryPolicy& RetryPolicy::setRetryCondition(std::function<bool(const exception::SQLiteError&)> aRetryCondition) {
+	retryCondition = std::move(aRetryCondition);
+	return *this;
+}
+
+bool RetryPolicy::isRetriable(const exception::SQLiteError& error, unsigned int attempt) const {
+	if(attempt >= maxAttempts) {
+		return false;
+	}
+	return retryCondition ? retryCondition(error) : error.isTransient();
+}
+
+void RetryPolicy::waitBeforeRetry(const exception::SQLiteError& error, unsigned int attempt) const {
+	double backoff = static_cast<double>(initialBackoff.count());
+	for(unsigned int i=1; i<attempt && backoff < maxBackoff.count(); ++i) {
+		backoff *= backoffMultiplier;
+	}
+	backoff = std::min(backoff, static_cast<double>(maxBackoff.count()));
+
+	/* jitter between 50% and 100% of the backoff to spread competing writers */
+	thread_local std::minstd_rand random(std::random_device{}());
+	std::uniform_real_distribution<double> jitter(0.5, 1.0);
+	std::chrono::milliseconds delay(static_cast<std::chrono::milliseconds::rep>(backoff * jitter(random)));
+
+	logger.debug << "Attempt " << attempt << " failed with extended code " << error.getExtendedCode() << ", retry in " << delay.count() << "ms: " << error.what() << "\n";
+	std::this_thread::sleep_for(delay);
+}
+
+void RetryPolicy::begin(const Connection& connection) const {
+	connection.prepareSQLite(beginStatement).step();
+}
+
+void RetryPolicy::rollback(const Connection& connection) const noexcept {
+	try {
+		/* sqlite3 might have rolled back the transaction already, e.g. on SQLITE_FULL */
+		if(sqlite3_get_autocommit(const_cast<sqlite3*>(&connection.getConnectionHandle())) == 0) {
+			connection.rollback();
+		}
+	}
+	catch(const std::exception& e) {
+		logger.warn << "Rollback failed: " << e.what() << "\n";
+	}
+	catch(...) {
+		logger.warn << "Rollback failed\n";
+	}
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
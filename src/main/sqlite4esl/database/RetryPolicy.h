@@ -0,0 +1,130 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_RETRYPOLICY_H_
+#define SQLITE4ESL_DATABASE_RETRYPOLICY_H_
+
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Runs idempotent work again with exponential backoff if it fails with a transient
+ * sqlite3 error (see exception::SQLiteError::isTransient()).
+ *
+ *   RetryPolicy retryPolicy;
+ *   retryPolicy.setMaxAttempts(5);
+ *   retryPolicy.execute([&] { statement.execute(); });
+ *   retryPolicy.executeTransaction(connection, [&] { ... });
+ */
+class RetryPolicy {
+public:
+	RetryPolicy& setMaxAttempts(unsigned int maxAttempts) noexcept;
+	RetryPolicy& setInitialBackoff(std::chrono::milliseconds initialBackoff) noexcept;
+	RetryPolicy& setMaxBackoff(std::chrono::milliseconds maxBackoff) noexcept;
+	RetryPolicy& setBackoffMultiplier(double backoffMultiplier) noexcept;
+	/* Transactions are started with "BEGIN IMMEDIATE" by default, so write transactions
+	 * acquire their lock up front and do not fail with SQLITE_BUSY_SNAPSHOT later */
+	RetryPolicy& setBeginStatement(std::string beginStatement);
+	/* Replaces the default classification by exception::SQLiteError::isTransient() */
+	RetryPolicy& setRetryCondition(std::function<bool(const exception::SQLiteError&)> retryCondition);
+
+	bool isRetriable(const exception::SQLiteError& error, unsigned int attempt) const;
+
+	template<typename Callable>
+	auto execute(Callable callable) const -> decltype(callable());
+
+	/* Runs "callable" within a transaction that is committed on success and rolled
+	 * back on any exception. The whole transaction is repeated on a transient error. */
+	template<typename Callable>
+	auto executeTransaction(const Connection& connection, Callable callable) const -> decltype(callable());
+
+private:
+	template<typename Result>
+	struct Committer {
+		template<typename Callable>
+		static Result run(const Connection& connection, Callable& callable) {
+			Result result = callable();
+			connection.commit();
+			return result;
+		}
+	};
+
+	void waitBeforeRetry(const exception::SQLiteError& error, unsigned int attempt) const;
+	void begin(const Connection& connection) const;
+	void rollback(const Connection& connection) const noexcept;
+
+	unsigned int maxAttempts = 5;
+	std::chrono::milliseconds initialBackoff = std::chrono::milliseconds(10);
+	std::chrono::milliseconds maxBackoff = std::chrono::milliseconds(1000);
+	double backoffMultiplier = 2.0;
+	std::string beginStatement = "BEGIN IMMEDIATE;";
+	std::function<bool(const exception::SQLiteError&)> retryCondition;
+};
+
+template<>
+struct RetryPolicy::Committer<void> {
+	template<typename Callable>
+	static void run(const Connection& connection, Callable& callable) {
+		callable();
+		connection.commit();
+	}
+};
+
+template<typename Callable>
+auto RetryPolicy::execute(Callable callable) const -> decltype(callable()) {
+	for(unsigned int attempt = 1;; ++attempt) {
+		try {
+			return callable();
+		}
+		catch(const exception::SQLiteError& error) {
+			if(!isRetriable(error, attempt)) {
+				throw;
+			}
+			waitBeforeRetry(error, attempt);
+		}
+	}
+}
+
+template<typename Callable>
+auto RetryPolicy::executeTransaction(const Connection& connection, Callable callable) const -> decltype(callable()) {
+	using Result = decltype(callable());
+
+	return execute([this, &connection, &callable]() -> Result {
+		begin(connection);
+		try {
+			return Committer<Result>::run(connection, callable);
+		}
+		catch(...) {
+			rollback(connection);
+			throw;
+		}
+	});
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_RETRYPOLICY_H_ */
@@ -0,0 +1,171 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_ROWMAPPER_H_
+#define SQLITE4ESL_DATABASE_ROWMAPPER_H_
+
+#include <sqlite4esl/database/StatementHandle.h>
+#include <sqlite4esl/database/Value.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Maps result columns by name to members of "Row". Column indexes are resolved once
+ * per execution, rows are decoded directly from sqlite3_column_* with Value<T>::column()
+ * into the members, without intermediate esl::database::Field objects.
+ *
+ *   struct User {
+ *       std::int64_t id;
+ *       std::string name;
+ *   };
+ *
+ *   auto mapper = makeRowMapper(rowField("id", &User::id), rowField("name", &User::name));
+ *   std::vector<User> users;
+ *   mapper.fetchAll(connection.prepareSQLite("SELECT id, name FROM user;"), users);
+ */
+template<typename Row, typename Member>
+struct RowField {
+	const char* name;
+	Member Row::*member;
+};
+
+template<typename Row, typename Member>
+RowField<Row, Member> rowField(const char* name, Member Row::*member) {
+	return RowField<Row, Member>{name, member};
+}
+
+template<typename Row, typename... Members>
+class RowMapper {
+public:
+	RowMapper(RowField<Row, Members>... aFields)
+	: fields(aFields...)
+	{ }
+
+	/* Steps the statement and decodes the next row into "row", returns false if there
+	 * is no more row */
+	bool fetch(const StatementHandle& statementHandle, Row& row) {
+		sqlite3_stmt& statement = statementHandle.getHandle();
+		if(resolvedStatement != &statement || sqlite3_stmt_busy(&statement) == 0) {
+			resolve(statement);
+		}
+
+		if(!statementHandle.step()) {
+			return false;
+		}
+
+		decode(statement, row, std::integral_constant<std::size_t, 0>());
+		return true;
+	}
+
+	/* Decodes all rows into "rows". Existing elements are overwritten and reuse their
+	 * memory, "rows" is resized to the number of rows. */
+	std::size_t fetchAll(const StatementHandle& statementHandle, std::vector<Row>& rows) {
+		std::size_t count = 0;
+
+		for(;;) {
+			if(count == rows.size()) {
+				rows.emplace_back();
+			}
+			if(!fetch(statementHandle, rows[count])) {
+				break;
+			}
+			++count;
+		}
+		rows.resize(count);
+
+		statementHandle.reset();
+		return count;
+	}
+
+	std::vector<Row> fetchAll(const StatementHandle& statementHandle) {
+		std::vector<Row> rows;
+		fetchAll(statementHandle, rows);
+		return rows;
+	}
+
+private:
+	static constexpr std::size_t fieldCount = sizeof...(Members);
+
+	void resolve(sqlite3_stmt& statement) {
+		resolve(statement, std::integral_constant<std::size_t, 0>());
+		resolvedStatement = &statement;
+	}
+
+	void resolve(sqlite3_stmt&, std::integral_constant<std::size_t, fieldCount>) {
+	}
+
+	template<std::size_t I>
+	void resolve(sqlite3_stmt& statement, std::integral_constant<std::size_t, I>) {
+		const char* name = std::get<I>(fields).name;
+		int columnCount = sqlite3_column_count(&statement);
+
+		columnIndexes[I] = -1;
+		for(int i = 0; i < columnCount; ++i) {
+			if(sqlite3_stricmp(sqlite3_column_name(&statement, i), name) == 0) {
+				columnIndexes[I] = i;
+				break;
+			}
+		}
+		if(columnIndexes[I] < 0) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Result has no column \"" + std::string(name) + "\" to map"));
+		}
+
+		resolve(statement, std::integral_constant<std::size_t, I + 1>());
+	}
+
+	void decode(sqlite3_stmt&, Row&, std::integral_constant<std::size_t, fieldCount>) {
+	}
+
+	template<std::size_t I>
+	void decode(sqlite3_stmt& statement, Row& row, std::integral_constant<std::size_t, I>) {
+		decodeField(statement, columnIndexes[I], row, std::get<I>(fields));
+		decode(statement, row, std::integral_constant<std::size_t, I + 1>());
+	}
+
+	template<typename Member>
+	static void decodeField(sqlite3_stmt& statement, int index, Row& row, const RowField<Row, Member>& field) {
+		Value<Member>::column(statement, index, row.*(field.member));
+	}
+
+	std::tuple<RowField<Row, Members>...> fields;
+	sqlite3_stmt* resolvedStatement = nullptr;
+	int columnIndexes[fieldCount == 0 ? 1 : fieldCount];
+};
+
+template<typename Row, typename... Members>
+RowMapper<Row, Members...> makeRowMapper(RowField<Row, Members>... fields) {
+	return RowMapper<Row, Members...>(fields...);
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_ROWMAPPER_H_ */
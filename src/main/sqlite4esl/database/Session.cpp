@@ -0,0 +1,253 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/Session.h>
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <esl/Logger.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <memory>
+#include <stdexcept>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::Session");
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+int onConflict(void* conflictPolicyPtr, int conflictType, sqlite3_changeset_iter*) {
+	Changeset::ConflictPolicy conflictPolicy = *static_cast<Changeset::ConflictPolicy*>(conflictPolicyPtr);
+
+	switch(conflictPolicy) {
+	case Changeset::ConflictPolicy::omit:
+		return SQLITE_CHANGESET_OMIT;
+	case Changeset::ConflictPolicy::replace:
+		/* REPLACE is allowed only for DATA and CONFLICT */
+		if(conflictType == SQLITE_CHANGESET_DATA || conflictType == SQLITE_CHANGESET_CONFLICT) {
+			return SQLITE_CHANGESET_REPLACE;
+		}
+		return SQLITE_CHANGESET_OMIT;
+	case Changeset::ConflictPolicy::abort:
+	default:
+		break;
+	}
+
+	return SQLITE_CHANGESET_ABORT;
+}
+#endif
+
+void throwUnavailable() {
+    throw esl::system::Stacktrace::add(std::runtime_error("Changesets are not available, because sqlite3 is compiled without SQLITE_ENABLE_SESSION and SQLITE_ENABLE_PREUPDATE_HOOK"));
+}
+}
+
+Changeset::Changeset(std::string aData)
+: data(std::move(aData))
+{ }
+
+const std::string& Changeset::getData() const noexcept {
+	return data;
+}
+
+bool Changeset::isEmpty() const noexcept {
+	return data.empty();
+}
+
+Changeset& Changeset::operator+=(const Changeset& changeset) {
+	if(changeset.isEmpty()) {
+		return *this;
+	}
+	if(isEmpty()) {
+		data = changeset.data;
+		return *this;
+	}
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	int size = 0;
+	void* buffer = nullptr;
+	int rc = sqlite3changeset_concat(static_cast<int>(data.size()), const_cast<char*>(data.data()),
+			static_cast<int>(changeset.data.size()), const_cast<char*>(changeset.data.data()), &size, &buffer);
+	if(rc != SQLITE_OK) {
+		sqlite3_free(buffer);
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot concatenate changesets", rc));
+	}
+
+	data.assign(static_cast<const char*>(buffer), static_cast<std::size_t>(size));
+	sqlite3_free(buffer);
+#else
+	throwUnavailable();
+#endif
+
+	return *this;
+}
+
+Changeset Changeset::invert() const {
+	if(isEmpty()) {
+		return Changeset();
+	}
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	int size = 0;
+	void* buffer = nullptr;
+	int rc = sqlite3changeset_invert(static_cast<int>(data.size()), data.data(), &size, &buffer);
+	if(rc != SQLITE_OK) {
+		sqlite3_free(buffer);
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot invert changeset", rc));
+	}
+
+	Changeset changeset(std::string(static_cast<const char*>(buffer), static_cast<std::size_t>(size)));
+	sqlite3_free(buffer);
+	return changeset;
+#else
+	throwUnavailable();
+	return Changeset();
+#endif
+}
+
+void Changeset::apply(const Connection& connection, ConflictPolicy conflictPolicy) const {
+	if(isEmpty()) {
+		return;
+	}
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	sqlite3& connectionHandle = const_cast<sqlite3&>(connection.getConnectionHandle());
+
+	/* sqlite3 applies the changeset in a savepoint, so it is applied completely or not at all */
+	int rc = sqlite3changeset_apply(&connectionHandle, static_cast<int>(data.size()), const_cast<char*>(data.data()),
+			nullptr, onConflict, &conflictPolicy);
+
+	/* publish the written tables to change capture and the result cache */
+	HandleContext* handleContext = connection.getHandleContext();
+	if(handleContext && handleContext->changeRecorder) {
+		handleContext->changeRecorder->publishCommitted();
+	}
+
+	if(rc != SQLITE_OK) {
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot apply changeset", rc, &connectionHandle));
+	}
+#else
+	static_cast<void>(connection);
+	static_cast<void>(conflictPolicy);
+	throwUnavailable();
+#endif
+}
+
+void Changeset::apply(ConnectionFactory& connectionFactory, ConflictPolicy conflictPolicy) const {
+	std::unique_ptr<esl::database::Connection> connection = connectionFactory.createConnection();
+	if(!connection) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot apply changeset, because no connection is available"));
+	}
+	apply(static_cast<const Connection&>(*connection), conflictPolicy);
+}
+
+Session::Session(const Connection& connection, std::vector<std::string> aTables, std::string aDatabase)
+: connectionHandle(const_cast<sqlite3&>(connection.getConnectionHandle())),
+  tables(std::move(aTables)),
+  database(std::move(aDatabase))
+{
+	const esl::database::SQLiteConnectionFactory::Settings& settings = connection.getConnectionFactory().getSettings();
+	if(settings.changeCapture && settings.changeCaptureValues) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Sessions cannot be used together with setting \"changeCaptureValues\""));
+	}
+
+	create();
+}
+
+Session::~Session() {
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	if(session) {
+		sqlite3session_delete(session);
+	}
+#endif
+}
+
+bool Session::isAvailable() noexcept {
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	return true;
+#else
+	return false;
+#endif
+}
+
+Changeset Session::takeChangeset() {
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	if(sqlite3_get_autocommit(&connectionHandle) == 0) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Cannot take changeset inside of a transaction"));
+	}
+
+	int size = 0;
+	void* buffer = nullptr;
+	int rc = sqlite3session_changeset(session, &size, &buffer);
+	if(rc != SQLITE_OK) {
+		sqlite3_free(buffer);
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot create changeset", rc, &connectionHandle));
+	}
+
+	Changeset changeset(std::string(static_cast<const char*>(buffer), static_cast<std::size_t>(size)));
+	sqlite3_free(buffer);
+
+	/* a session cannot be cleared, so recording starts again with a new session */
+	sqlite3session_delete(session);
+	session = nullptr;
+	create();
+
+	return changeset;
+#else
+	throwUnavailable();
+	return Changeset();
+#endif
+}
+
+void Session::create() {
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	int rc = sqlite3session_create(&connectionHandle, database.c_str(), &session);
+	if(rc != SQLITE_OK) {
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot create session for database \"" + database + "\"", rc, &connectionHandle));
+	}
+
+	if(tables.empty()) {
+		rc = sqlite3session_attach(session, nullptr);
+	}
+	else {
+		for(const auto& table : tables) {
+			rc = sqlite3session_attach(session, table.c_str());
+			if(rc != SQLITE_OK) {
+				break;
+			}
+		}
+	}
+
+	if(rc != SQLITE_OK) {
+		sqlite3session_delete(session);
+		session = nullptr;
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot attach tables to session", rc, &connectionHandle));
+	}
+#else
+	throwUnavailable();
+#endif
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,105 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_SESSION_H_
+#define SQLITE4ESL_DATABASE_SESSION_H_
+
+#include <sqlite3.h>
+
+#include <string>
+#include <vector>
+
+/* declared by sqlite3.h only with SQLITE_ENABLE_SESSION */
+struct sqlite3_session;
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+class Connection;
+class ConnectionFactory;
+
+/* Serialized changes of the sqlite3 session extension. The data is the binary
+ * changeset format of sqlite3, so it can be stored or sent as it is. */
+class Changeset {
+public:
+	enum class ConflictPolicy {
+		/* skip the conflicting change */
+		omit,
+		/* overwrite the conflicting row, changes of missing rows and changes violating
+		 * constraints are skipped */
+		replace,
+		/* roll back the whole changeset and throw */
+		abort
+	};
+
+	Changeset() = default;
+	explicit Changeset(std::string data);
+
+	const std::string& getData() const noexcept;
+	bool isEmpty() const noexcept;
+
+	/* Appends the changes of "changeset", e.g. to ship several transactions at once */
+	Changeset& operator+=(const Changeset& changeset);
+	/* Returns the changeset that undoes this changeset */
+	Changeset invert() const;
+
+	/* Applies all changes in one transaction to "connection" */
+	void apply(const Connection& connection, ConflictPolicy conflictPolicy = ConflictPolicy::abort) const;
+	void apply(ConnectionFactory& connectionFactory, ConflictPolicy conflictPolicy = ConflictPolicy::abort) const;
+
+private:
+	std::string data;
+};
+
+/* Records the changes of a connection with the sqlite3 session extension, so a replica
+ * can be updated with work proportional to the changes instead of copying the file.
+ * Requires sqlite3 with SQLITE_ENABLE_SESSION and SQLITE_ENABLE_PREUPDATE_HOOK.
+ * Only tables with a PRIMARY KEY are recorded. Like the connection a session is used by
+ * one thread and it has to be destroyed before the connection. Sessions cannot be used
+ * together with setting "changeCaptureValues", because both need the preupdate hook. */
+class Session {
+public:
+	/* Records the changes of "tables" of database "database", all tables if empty */
+	Session(const Connection& connection, std::vector<std::string> tables = std::vector<std::string>(), std::string database = "main");
+	Session(const Session&) = delete;
+	~Session();
+
+	Session& operator=(const Session&) = delete;
+
+	static bool isAvailable() noexcept;
+
+	/* Returns the changes recorded since construction or since the last call, i.e. the
+	 * changes of the transactions committed in between if called after every commit.
+	 * Throws inside of a transaction. */
+	Changeset takeChangeset();
+
+private:
+	void create();
+
+	sqlite3& connectionHandle;
+	std::vector<std::string> tables;
+	std::string database;
+	sqlite3_session* session = nullptr;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_SESSION_H_ */
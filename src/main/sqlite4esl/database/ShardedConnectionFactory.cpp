@@ -0,0 +1,280 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/ShardedConnectionFactory.h>
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/StatementHandle.h>
+
+#include <esl/Logger.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+esl::Logger logger("sqlite4esl::database::ShardedConnectionFactory");
+
+std::string quoteIdentifier(const std::string& identifier) {
+	std::string quoted = "\"";
+	for(char c : identifier) {
+		if(c == '"') {
+			quoted += '"';
+		}
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+}
+
+std::size_t ShardedConnectionFactory::defaultHash(const esl::database::Field& key) {
+	if(key.isNull()) {
+		return 0;
+	}
+
+	switch(key.getSimpleType()) {
+	case esl::database::Field::Type::storageBoolean:
+	case esl::database::Field::Type::storageInteger:
+		return std::hash<std::int64_t>()(key.asInteger());
+	default:
+		break;
+	}
+	return std::hash<std::string>()(key.asString());
+}
+
+ShardedConnectionFactory::ShardedConnectionFactory(std::vector<esl::database::SQLiteConnectionFactory::Settings> shardSettings, Hash aHash)
+: hash(std::move(aHash))
+{
+	if(shardSettings.empty()) {
+        throw esl::system::Stacktrace::add(std::runtime_error("ShardedConnectionFactory requires at least one shard"));
+	}
+
+	for(auto& settings : shardSettings) {
+		connectionFactories.emplace_back(new ConnectionFactory(std::move(settings)));
+		shardStatistics.emplace_back(new ShardStatistics);
+	}
+}
+
+std::size_t ShardedConnectionFactory::getShardCount() const noexcept {
+	return connectionFactories.size();
+}
+
+std::size_t ShardedConnectionFactory::getShard(const esl::database::Field& key) const {
+	return hash(key) % connectionFactories.size();
+}
+
+ConnectionFactory& ShardedConnectionFactory::getConnectionFactory(std::size_t shard) {
+	if(shard >= connectionFactories.size()) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Shard " + std::to_string(shard) + " does not exist, there are " + std::to_string(connectionFactories.size()) + " shards"));
+	}
+	return *connectionFactories[shard];
+}
+
+std::unique_ptr<esl::database::Connection> ShardedConnectionFactory::createConnection(const esl::database::Field& key) {
+	std::size_t shard = getShard(key);
+	++shardStatistics[shard]->routedConnections;
+	return connectionFactories[shard]->createConnection();
+}
+
+void ShardedConnectionFactory::fanOut(const std::string& sql, const std::vector<esl::database::Field>& parameters, RowConsumer consumer) {
+	forEachShard([&](std::size_t shard) {
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		std::uint64_t rows = 0;
+
+		std::unique_ptr<esl::database::Connection> connection = connectionFactories[shard]->createConnection();
+		if(!connection) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Cannot fan out to shard " + std::to_string(shard) + ", because no connection is available"));
+		}
+		StatementHandle statementHandle = static_cast<Connection&>(*connection).prepareSQLite(sql);
+		statementHandle.bind(parameters);
+
+		Row row(statementHandle.columnCount());
+		while(statementHandle.step()) {
+			statementHandle.columns(row);
+			++rows;
+			consumer(shard, row);
+		}
+
+		ShardStatistics& statistics = *shardStatistics[shard];
+		++statistics.fanOutQueries;
+		statistics.fanOutRows += rows;
+		statistics.fanOutMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+	});
+}
+
+std::vector<ShardedConnectionFactory::Row> ShardedConnectionFactory::fanOut(const std::string& sql, const std::vector<esl::database::Field>& parameters) {
+	/* every shard collects into its own vector, so no lock is needed */
+	std::vector<std::vector<Row>> shardRows(connectionFactories.size());
+	fanOut(sql, parameters, [&shardRows](std::size_t shard, const Row& row) {
+		shardRows[shard].push_back(row);
+	});
+
+	std::size_t size = 0;
+	for(const auto& rows : shardRows) {
+		size += rows.size();
+	}
+
+	std::vector<Row> rows;
+	rows.reserve(size);
+	for(auto& shardRow : shardRows) {
+		for(auto& row : shardRow) {
+			rows.push_back(std::move(row));
+		}
+	}
+	return rows;
+}
+
+std::uint64_t ShardedConnectionFactory::exportTable(ShardedConnectionFactory& target, const std::string& table, const std::string& keyColumn) {
+	/* one writer per target shard, each in its own transaction */
+	std::vector<std::unique_ptr<esl::database::Connection>> targetConnections;
+	std::vector<StatementHandle> insertStatements;
+	for(auto& connectionFactory : target.connectionFactories) {
+		targetConnections.push_back(connectionFactory->createConnection());
+		if(!targetConnections.back()) {
+	        throw esl::system::Stacktrace::add(std::runtime_error("Cannot export table \"" + table + "\", because no connection to target shard " + std::to_string(targetConnections.size() - 1) + " is available"));
+		}
+	}
+
+	std::uint64_t exportedRows = 0;
+	try {
+		for(std::size_t shard=0; shard<connectionFactories.size(); ++shard) {
+			std::unique_ptr<esl::database::Connection> connection = connectionFactories[shard]->createConnection();
+			if(!connection) {
+		        throw esl::system::Stacktrace::add(std::runtime_error("Cannot export table \"" + table + "\", because no connection to shard " + std::to_string(shard) + " is available"));
+			}
+			StatementHandle selectStatement = static_cast<Connection&>(*connection).prepareSQLite("SELECT * FROM " + quoteIdentifier(table));
+
+			std::size_t keyIndex = selectStatement.columnCount();
+			for(std::size_t i=0; i<selectStatement.columnCount(); ++i) {
+				if(selectStatement.columnName(i) == keyColumn) {
+					keyIndex = i;
+					break;
+				}
+			}
+			if(keyIndex == selectStatement.columnCount()) {
+				throw esl::system::Stacktrace::add(std::runtime_error("Table \"" + table + "\" has no column \"" + keyColumn + "\""));
+			}
+
+			if(insertStatements.empty()) {
+				std::string sql = "INSERT INTO " + quoteIdentifier(table) + " VALUES (";
+				for(std::size_t i=0; i<selectStatement.columnCount(); ++i) {
+					sql += i == 0 ? "?" : ", ?";
+				}
+				sql += ")";
+
+				for(auto& targetConnection : targetConnections) {
+					const Connection& sqliteConnection = static_cast<Connection&>(*targetConnection);
+					sqliteConnection.prepareSQLite("BEGIN IMMEDIATE").step();
+					insertStatements.push_back(sqliteConnection.prepareSQLite(sql));
+				}
+			}
+
+			std::uint64_t shardRows = 0;
+			Row row(selectStatement.columnCount());
+			while(selectStatement.step()) {
+				selectStatement.columns(row);
+
+				const StatementHandle& insertStatement = insertStatements[target.getShard(row[keyIndex])];
+				insertStatement.bind(row);
+				insertStatement.step();
+				insertStatement.reset();
+				++shardRows;
+			}
+
+			shardStatistics[shard]->exportedRows += shardRows;
+			exportedRows += shardRows;
+		}
+	}
+	catch(...) {
+		insertStatements.clear();
+		for(auto& targetConnection : targetConnections) {
+			if(sqlite3_get_autocommit(static_cast<sqlite3*>(targetConnection->getNativeHandle())) == 0) {
+				targetConnection->rollback();
+			}
+		}
+		throw;
+	}
+
+	insertStatements.clear();
+	for(auto& targetConnection : targetConnections) {
+		if(sqlite3_get_autocommit(static_cast<sqlite3*>(targetConnection->getNativeHandle())) == 0) {
+			targetConnection->commit();
+		}
+	}
+
+	logger.info << "Exported " << exportedRows << " rows of table \"" << table << "\" from " << connectionFactories.size() << " to " << target.connectionFactories.size() << " shards\n";
+	return exportedRows;
+}
+
+ShardedConnectionFactory::Statistics ShardedConnectionFactory::getStatistics(std::size_t shard) const {
+	if(shard >= connectionFactories.size()) {
+        throw esl::system::Stacktrace::add(std::runtime_error("Shard " + std::to_string(shard) + " does not exist, there are " + std::to_string(connectionFactories.size()) + " shards"));
+	}
+
+	const ShardStatistics& shardStatistic = *shardStatistics[shard];
+	Statistics statistics;
+	statistics.routedConnections = shardStatistic.routedConnections;
+	statistics.fanOutQueries = shardStatistic.fanOutQueries;
+	statistics.fanOutRows = shardStatistic.fanOutRows;
+	statistics.fanOutDuration = std::chrono::microseconds(shardStatistic.fanOutMicroseconds);
+	statistics.exportedRows = shardStatistic.exportedRows;
+	statistics.memoryStatistics = connectionFactories[shard]->getMemoryStatistics();
+	return statistics;
+}
+
+void ShardedConnectionFactory::forEachShard(std::function<void(std::size_t shard)> function) {
+	std::vector<std::exception_ptr> errors(connectionFactories.size());
+	std::vector<std::thread> threads;
+
+	for(std::size_t shard=1; shard<connectionFactories.size(); ++shard) {
+		threads.emplace_back([&function, &errors, shard]() {
+			try {
+				function(shard);
+			}
+			catch(...) {
+				errors[shard] = std::current_exception();
+			}
+		});
+	}
+
+	try {
+		function(0);
+	}
+	catch(...) {
+		errors[0] = std::current_exception();
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	for(const auto& error : errors) {
+		if(error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,106 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_SHARDEDCONNECTIONFACTORY_H_
+#define SQLITE4ESL_DATABASE_SHARDEDCONNECTIONFACTORY_H_
+
+#include <sqlite4esl/database/ConnectionFactory.h>
+
+#include <esl/database/Connection.h>
+#include <esl/database/Field.h>
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Distributes rows over several database files, each with its own ConnectionFactory,
+ * so every shard has its own writer. Statements for one key are routed to the shard of
+ * the key, reads over all shards run in parallel with one thread per shard. All shards
+ * are expected to have the same schema. */
+class ShardedConnectionFactory {
+public:
+	using Hash = std::function<std::size_t(const esl::database::Field& key)>;
+	using Row = std::vector<esl::database::Field>;
+	/* Called on the thread of the shard, so it has to be thread safe */
+	using RowConsumer = std::function<void(std::size_t shard, const Row& row)>;
+
+	struct Statistics {
+		std::uint64_t routedConnections = 0;
+		std::uint64_t fanOutQueries = 0;
+		std::uint64_t fanOutRows = 0;
+		std::chrono::microseconds fanOutDuration = std::chrono::microseconds(0);
+		std::uint64_t exportedRows = 0;
+		MemoryStatistics memoryStatistics;
+	};
+
+	/* Hashes integers by value and everything else by its string representation */
+	static std::size_t defaultHash(const esl::database::Field& key);
+
+	ShardedConnectionFactory(std::vector<esl::database::SQLiteConnectionFactory::Settings> shardSettings, Hash hash = defaultHash);
+
+	std::size_t getShardCount() const noexcept;
+	std::size_t getShard(const esl::database::Field& key) const;
+	ConnectionFactory& getConnectionFactory(std::size_t shard);
+
+	/* Connection of the shard of "key" */
+	std::unique_ptr<esl::database::Connection> createConnection(const esl::database::Field& key);
+
+	/* Runs "sql" on every shard in parallel and passes the rows to "consumer" */
+	void fanOut(const std::string& sql, const std::vector<esl::database::Field>& parameters, RowConsumer consumer);
+	/* Runs "sql" on every shard in parallel and returns the rows ordered by shard */
+	std::vector<Row> fanOut(const std::string& sql, const std::vector<esl::database::Field>& parameters = std::vector<esl::database::Field>());
+
+	/* Copies the rows of "table" of every shard to the shard of "target" given by column
+	 * "keyColumn", e.g. to change the number of shards. The table has to exist in
+	 * "target", the rows of this factory are not removed. Returns the number of rows. */
+	std::uint64_t exportTable(ShardedConnectionFactory& target, const std::string& table, const std::string& keyColumn);
+
+	Statistics getStatistics(std::size_t shard) const;
+
+private:
+	struct ShardStatistics {
+		std::atomic<std::uint64_t> routedConnections{0};
+		std::atomic<std::uint64_t> fanOutQueries{0};
+		std::atomic<std::uint64_t> fanOutRows{0};
+		std::atomic<std::uint64_t> fanOutMicroseconds{0};
+		std::atomic<std::uint64_t> exportedRows{0};
+	};
+
+	/* Runs "function" for every shard, shard 0 on the calling thread */
+	void forEachShard(std::function<void(std::size_t shard)> function);
+
+	Hash hash;
+	std::vector<std::unique_ptr<ConnectionFactory>> connectionFactories;
+	std::vector<std::unique_ptr<ShardStatistics>> shardStatistics;
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_SHARDEDCONNECTIONFACTORY_H_ */
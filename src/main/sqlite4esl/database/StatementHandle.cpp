@@ -17,6 +17,10 @@
  */
 
 #include <sqlite4esl/database/StatementHandle.h>
+#include <sqlite4esl/database/ExecutionStatistics.h>
+#include <sqlite4esl/database/PreparedBulkStatementBinding.h>
+#include <sqlite4esl/database/UnlockNotification.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
 
 #include <esl/Logger.h>
 
@@ -25,6 +29,7 @@
 #include <esl/monitoring/Streams.h>
 
 #include <stdexcept>
+#include <utility>
 
 namespace sqlite4esl {
 inline namespace v1_6 {
@@ -35,9 +40,19 @@ esl::Logger logger("sqlite4esl::database::PreparedHandle");
 }
 
 StatementHandle::StatementHandle(StatementHandle&& other)
-: handle(other.handle)
+: handle(other.handle),
+  queryPlan(other.queryPlan),
+  hotStatements(other.hotStatements),
+  handleContext(other.handleContext),
+  executionLimits(std::move(other.executionLimits)),
+  hasDeadline(other.hasDeadline),
+  deadline(other.deadline),
+  hasRow(other.hasRow)
 {
 	other.handle = nullptr;
+	other.queryPlan = nullptr;
+	other.hotStatements = nullptr;
+	other.handleContext = nullptr;
 	logger.trace << "Statement handle constructed (moved)\n";
 }
 
@@ -46,6 +61,12 @@ StatementHandle::StatementHandle(sqlite3_stmt& aHandle)
 {
 }
 
+StatementHandle::StatementHandle(sqlite3_stmt& aHandle, HotStatements& aHotStatements)
+: handle(&aHandle),
+  hotStatements(&aHotStatements)
+{
+}
+
 StatementHandle::~StatementHandle() {
 	if(handle == nullptr) {
 		logger.debug << "Close statement handle (closed already)\n";
@@ -59,11 +80,20 @@ StatementHandle::~StatementHandle() {
 	location.function = __func__;
 
 	try {
+		if(queryPlan) {
+			queryPlan->collect(getHandle());
+		}
+
+		if(hotStatements) {
+			hotStatements->release(getHandle());
+			return;
+		}
+
 		// free statement handle
 		//Driver::getDriver().finalize(*this);
 		int rc = sqlite3_finalize(&getHandle());
 		if(rc != SQLITE_OK) {
-	        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Can't close statement handle: ") + sqlite3_errstr(rc)));
+	        throw esl::system::Stacktrace::add(exception::SQLiteError("Can't close statement handle", rc));
 		}
 	}
 	catch (const esl::database::exception::SqlError& e) {
@@ -102,8 +132,16 @@ StatementHandle::~StatementHandle() {
 }
 
 StatementHandle& StatementHandle::operator=(StatementHandle&& other) {
-	handle = other.handle;
-	other.handle = nullptr;
+	/* the current statement is given to "previous" and released or finalized by its destructor */
+	StatementHandle previous(std::move(other));
+	std::swap(handle, previous.handle);
+	std::swap(queryPlan, previous.queryPlan);
+	std::swap(hotStatements, previous.hotStatements);
+	std::swap(handleContext, previous.handleContext);
+	std::swap(executionLimits, previous.executionLimits);
+	std::swap(hasDeadline, previous.hasDeadline);
+	std::swap(deadline, previous.deadline);
+	std::swap(hasRow, previous.hasRow);
 	logger.trace << "Statement handle moved\n";
 	return *this;
 }
@@ -113,30 +151,71 @@ StatementHandle::operator bool() const noexcept {
 }
 
 bool StatementHandle::step() const {
+	/* rows buffered by bulk statements have to be visible to this statement */
+	if(handleContext && !handleContext->bufferingBulkStatements.empty()) {
+		PreparedBulkStatementBinding::flush(*handleContext);
+	}
+
+	bool executionStarts = sqlite3_stmt_busy(&getHandle()) == 0;
+	if(executionStarts) {
+		hasRow = false;
+	}
+
+	ExecutionControl* executionControl = (executionLimits && handleContext) ? handleContext->executionControl.get() : nullptr;
+	if(executionControl) {
+		if(executionStarts) {
+			executionLimits->interrupted.store(false);
+			hasDeadline = executionLimits->timeout.count() > 0;
+			if(hasDeadline) {
+				deadline = std::chrono::steady_clock::now() + executionLimits->timeout;
+			}
+		}
+		/* armed for every step, statements of other connections may run in between */
+		executionControl->arm(hasDeadline ? &deadline : nullptr, &executionLimits->cancellationToken, &executionLimits->interrupted);
+	}
+
 	int rc = sqlite3_step(&getHandle());
+	while(rc == SQLITE_LOCKED_SHAREDCACHE && !hasRow) {
+		/* table is locked by another handle of the same shared cache. Restarting is only
+		 * possible as long as the caller has not seen rows of this execution. */
+		rc = UnlockNotification::wait(*sqlite3_db_handle(handle));
+		if(rc != SQLITE_OK) {
+			break;
+		}
+		sqlite3_reset(handle);
+		rc = sqlite3_step(handle);
+	}
 
-	switch(rc) {
-	case SQLITE_DONE:
-	case SQLITE_ROW:
-		break;
-	case SQLITE_BUSY:
-        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Cannot fetch, because sqlite3_step returned SQLITE_BUSY: ") + sqlite3_errstr(rc)));
-	case SQLITE_MISUSE:
-        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Cannot fetch, because sqlite3_step returned SQLITE_MISUSE: ") + sqlite3_errstr(rc)));
-	case SQLITE_ERROR:
-        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Cannot fetch, because sqlite3_step returned SQLITE_ERROR: ") + sqlite3_errstr(rc)));
-	default:
-        throw esl::system::Stacktrace::add(std::runtime_error("Cannot fetch, because sqlite3_step returned " + std::to_string(rc) + ": " + sqlite3_errstr(rc)));
+	if(executionControl) {
+		executionControl->disarm();
+	}
+
+	ExecutionStatistics::add(ExecutionStatistics::steps);
+	if(handleContext && handleContext->changeRecorder) {
+		handleContext->changeRecorder->publishCommitted();
 	}
 
-	return rc == SQLITE_ROW;
+	if(rc != SQLITE_DONE && rc != SQLITE_ROW) {
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Cannot fetch, because sqlite3_step failed", rc, sqlite3_db_handle(handle)));
+	}
+
+	if(rc == SQLITE_ROW) {
+		hasRow = true;
+		ExecutionStatistics::add(ExecutionStatistics::rows);
+		return true;
+	}
+	return false;
 }
 
 void StatementHandle::reset() const {
+	if(queryPlan) {
+		queryPlan->collect(getHandle());
+	}
+
 	int rc = sqlite3_reset(&getHandle());
 
 	if(rc != SQLITE_OK) {
-        throw esl::system::Stacktrace::add(std::runtime_error(std::string("Can't reset statement handle: ") + sqlite3_errstr(rc)));
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Can't reset statement handle", rc, sqlite3_db_handle(handle)));
 	}
 }
 
@@ -206,9 +285,41 @@ std::string StatementHandle::columnText(std::size_t index) const {
         throw esl::system::Stacktrace::add(std::runtime_error("sqlite3_column_bytes returned a negative value: " + std::to_string(length)));
 	}
 
+	ExecutionStatistics::add(ExecutionStatistics::bytesFetched, static_cast<std::uint64_t>(length));
 	return std::string(data, static_cast<std::size_t>(length));
 }
 
+void StatementHandle::columns(std::vector<esl::database::Field>& fields) const {
+	for(std::size_t i=0; i<fields.size(); ++i) {
+		/* check if column value was NULL */
+		if(columnValueIsNull(i)) {
+			fields[i] = nullptr;
+			continue;
+		}
+
+		switch(columnType(i)) {
+		case esl::database::Column::Type::sqlInteger:
+		case esl::database::Column::Type::sqlSmallInt:
+			fields[i] = columnInteger(i);
+			break;
+
+		case esl::database::Column::Type::sqlDouble:
+		case esl::database::Column::Type::sqlNumeric:
+		case esl::database::Column::Type::sqlDecimal:
+		case esl::database::Column::Type::sqlFloat:
+		case esl::database::Column::Type::sqlReal:
+			fields[i] = columnDouble(i);
+			break;
+
+		case esl::database::Column::Type::sqlVarChar:
+		case esl::database::Column::Type::sqlChar:
+		default:
+			fields[i] = columnText(i);
+			break;
+		}
+	}
+}
+
 std::string StatementHandle::columnBlob(std::size_t index) const {
 	const char* data = static_cast<const char*>(sqlite3_column_blob(&getHandle(), static_cast<int>(index)));
 	if(data == nullptr) {
@@ -220,6 +331,7 @@ std::string StatementHandle::columnBlob(std::size_t index) const {
         throw esl::system::Stacktrace::add(std::runtime_error("sqlite3_column_bytes returned a negative value: " + std::to_string(length)));
 	}
 
+	ExecutionStatistics::add(ExecutionStatistics::bytesFetched, static_cast<std::uint64_t>(length));
 	return std::string(data, static_cast<std::size_t>(length));
 }
 
@@ -233,33 +345,39 @@ std::size_t StatementHandle::bindParameterCount() const {
 }
 
 void StatementHandle::bindNull(std::size_t index) const {
-	int rc = sqlite3_bind_null(&getHandle(), static_cast<int>(index));
+	int rc = sqlite3_bind_null(&getHandle(), static_cast<int>(index+1));
 
 	if(rc != SQLITE_OK) {
-		std::string message = "Cannot bind null value to parameter[" + std::to_string(index+1) + "]: " + sqlite3_errstr(rc);
+		std::string message = "Cannot bind null value to parameter[" + std::to_string(index) + "]";
 
-        throw esl::system::Stacktrace::add(std::runtime_error(message));
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, sqlite3_db_handle(handle)));
 	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings);
 }
 
 void StatementHandle::bindInteger(std::size_t index, std::int64_t value) const {
 	int rc = sqlite3_bind_int64(&getHandle(), static_cast<int>(index+1), static_cast<sqlite3_int64>(value));
 
 	if(rc != SQLITE_OK) {
-		std::string message = "Cannot bind integer value " + std::to_string(value) + " to parameter[" + std::to_string(index) + "]: " + sqlite3_errstr(rc);
+		std::string message = "Cannot bind integer value " + std::to_string(value) + " to parameter[" + std::to_string(index) + "]";
 
-        throw esl::system::Stacktrace::add(std::runtime_error(message));
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, sqlite3_db_handle(handle)));
 	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings);
 }
 
 void StatementHandle::bindDouble(std::size_t index, double value) const {
 	int rc = sqlite3_bind_double(&getHandle(), static_cast<int>(index+1), value);
 
 	if(rc != SQLITE_OK) {
-		std::string message = "Cannot bind double value " + std::to_string(value) + " to parameter[" + std::to_string(index) + "]: " + sqlite3_errstr(rc);
+		std::string message = "Cannot bind double value " + std::to_string(value) + " to parameter[" + std::to_string(index) + "]";
 
-        throw esl::system::Stacktrace::add(std::runtime_error(message));
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, sqlite3_db_handle(handle)));
 	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings);
 }
 
 void StatementHandle::bindText(std::size_t index, const std::string& value) const {
@@ -269,20 +387,81 @@ void StatementHandle::bindText(std::size_t index, const std::string& value) cons
 	int rc = sqlite3_bind_text(&getHandle(), static_cast<int>(index+1), str, static_cast<int>(length), SQLITE_TRANSIENT);
 
 	if(rc != SQLITE_OK) {
-		std::string message = "Cannot bind text value \"" + value + "\" to parameter[" + std::to_string(index) + "]: " + sqlite3_errstr(rc);
+		std::string message = "Cannot bind text value \"" + value + "\" to parameter[" + std::to_string(index) + "]";
 
-        throw esl::system::Stacktrace::add(std::runtime_error(message));
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, sqlite3_db_handle(handle)));
 	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings);
+	ExecutionStatistics::add(ExecutionStatistics::bytesBound, length);
 }
 
 void StatementHandle::bindBlob(std::size_t index, const std::string& value) const {
 	int rc = sqlite3_bind_blob(&getHandle(), static_cast<int>(index+1), value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
 
 	if(rc != SQLITE_OK) {
-		std::string message = "Cannot bind blob value \"" + value + "\" to parameter[" + std::to_string(index) + "]: " + sqlite3_errstr(rc);
+		std::string message = "Cannot bind blob value \"" + value + "\" to parameter[" + std::to_string(index) + "]";
+
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, sqlite3_db_handle(handle)));
+	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings);
+	ExecutionStatistics::add(ExecutionStatistics::bytesBound, value.size());
+}
+
+void StatementHandle::bindBlob(std::size_t index, const void* data, std::size_t size) const {
+	int rc = sqlite3_bind_blob(&getHandle(), static_cast<int>(index+1), data, static_cast<int>(size), SQLITE_STATIC);
+
+	if(rc != SQLITE_OK) {
+		std::string message = "Cannot bind blob value of " + std::to_string(size) + " bytes to parameter[" + std::to_string(index) + "]";
 
-        throw esl::system::Stacktrace::add(std::runtime_error(message));
+        throw esl::system::Stacktrace::add(exception::SQLiteError(message, rc, sqlite3_db_handle(handle)));
 	}
+
+	ExecutionStatistics::add(ExecutionStatistics::bindings);
+	ExecutionStatistics::add(ExecutionStatistics::bytesBound, size);
+}
+
+void StatementHandle::bind(const std::vector<esl::database::Field>& fields) const {
+	if(bindParameterCount() != fields.size()) {
+	    throw esl::system::Stacktrace::add(std::runtime_error("Wrong number of arguments. Given " + std::to_string(fields.size()) + " parameters but required " + std::to_string(bindParameterCount()) + " parameters."));
+	}
+
+	for(std::size_t i=0; i<fields.size(); ++i) {
+		if(fields[i].isNull()) {
+			bindNull(i);
+			continue;
+		}
+
+		switch(fields[i].getSimpleType()) {
+		case esl::database::Field::Type::storageBoolean:
+		case esl::database::Field::Type::storageInteger:
+			bindInteger(i, fields[i].asInteger());
+			break;
+		case esl::database::Field::Type::storageDouble:
+			bindDouble(i, fields[i].asDouble());
+			break;
+		case esl::database::Field::Type::storageString:
+			bindText(i, fields[i].asString());
+			break;
+		case esl::database::Field::Type::storageEmpty:
+		default:
+			bindNull(i);
+			break;
+		}
+	}
+}
+
+void StatementHandle::setQueryPlan(QueryPlan* aQueryPlan) noexcept {
+	queryPlan = aQueryPlan;
+}
+
+void StatementHandle::setHandleContext(HandleContext* aHandleContext) noexcept {
+	handleContext = aHandleContext;
+}
+
+void StatementHandle::setExecutionLimits(std::shared_ptr<const ExecutionControl::Limits> aExecutionLimits) noexcept {
+	executionLimits = std::move(aExecutionLimits);
 }
 
 sqlite3_stmt& StatementHandle::getHandle() const {
@@ -19,12 +19,20 @@
 #ifndef SQLITE4ESL_DATABASE_STATEMENTHANDLE_H_
 #define SQLITE4ESL_DATABASE_STATEMENTHANDLE_H_
 
+#include <sqlite4esl/database/HandleContext.h>
+#include <sqlite4esl/database/HotStatements.h>
+#include <sqlite4esl/database/QueryPlanRecorder.h>
+
 #include <esl/database/Column.h>
+#include <esl/database/Field.h>
 
 #include <sqlite3.h>
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace sqlite4esl {
 inline namespace v1_6 {
@@ -36,6 +44,8 @@ public:
 	StatementHandle(const StatementHandle&) = delete;
 	StatementHandle(StatementHandle&& statementHandle);
 	StatementHandle(sqlite3_stmt& handle);
+	/* Pinned statement, it is given back to "hotStatements" instead of finalized */
+	StatementHandle(sqlite3_stmt& handle, HotStatements& hotStatements);
 
 	~StatementHandle();
 
@@ -56,6 +66,8 @@ public:
 	double columnDouble(std::size_t index) const;
 	std::string columnText(std::size_t index) const;
 	std::string columnBlob(std::size_t index) const;
+	/* Converts the columns of the current row to integer, double, text or NULL */
+	void columns(std::vector<esl::database::Field>& fields) const;
 
 	std::size_t bindParameterCount() const;
 	void bindNull(std::size_t index) const;
@@ -63,11 +75,32 @@ public:
 	void bindDouble(std::size_t index, double value) const;
 	void bindText(std::size_t index, const std::string& value) const;
 	void bindBlob(std::size_t index, const std::string& value) const;
+	/* Binds without copying, "data" must stay valid until the statement is reset */
+	void bindBlob(std::size_t index, const void* data, std::size_t size) const;
+	/* Binds every parameter by the storage type of its field */
+	void bind(const std::vector<esl::database::Field>& fields) const;
 
 	sqlite3_stmt& getHandle() const;
 
+	/* Execution counters are collected into "queryPlan" on reset and on destruction */
+	void setQueryPlan(QueryPlan* queryPlan) noexcept;
+
+	/* Committed changes are published after the step that committed */
+	void setHandleContext(HandleContext* handleContext) noexcept;
+	/* Limits of the connection, checked by the execution control of the handle context.
+	 * The deadline starts with the first step of an execution. */
+	void setExecutionLimits(std::shared_ptr<const ExecutionControl::Limits> executionLimits) noexcept;
+
 protected:
 	sqlite3_stmt* handle = nullptr;
+	QueryPlan* queryPlan = nullptr;
+	HotStatements* hotStatements = nullptr;
+	HandleContext* handleContext = nullptr;
+	std::shared_ptr<const ExecutionControl::Limits> executionLimits;
+	mutable bool hasDeadline = false;
+	mutable std::chrono::steady_clock::time_point deadline;
+	/* the current execution has produced a row */
+	mutable bool hasRow = false;
 };
 
 } /* namespace database */
@@ -0,0 +1,61 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/UnlockNotification.h>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+namespace {
+struct Notification {
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool fired = false;
+};
+
+void unlockNotifyCallback(void** args, int argsCount) {
+	for(int i=0; i<argsCount; ++i) {
+		Notification& notification = *static_cast<Notification*>(args[i]);
+
+		std::lock_guard<std::mutex> lock(notification.mutex);
+		notification.fired = true;
+		notification.condition.notify_all();
+	}
+}
+}
+
+int UnlockNotification::wait(sqlite3& connectionHandle) {
+	Notification notification;
+
+	int rc = sqlite3_unlock_notify(&connectionHandle, unlockNotifyCallback, &notification);
+	if(rc == SQLITE_OK) {
+		/* callback might have been invoked immediately by sqlite3_unlock_notify */
+		std::unique_lock<std::mutex> lock(notification.mutex);
+		notification.condition.wait(lock, [&notification] { return notification.fired; });
+	}
+
+	return rc;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
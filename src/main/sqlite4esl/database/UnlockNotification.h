@@ -0,0 +1,41 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_UNLOCKNOTIFICATION_H_
+#define SQLITE4ESL_DATABASE_UNLOCKNOTIFICATION_H_
+
+#include <sqlite3.h>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Blocks the calling thread until the shared-cache lock that made the last call
+ * on "connectionHandle" fail with SQLITE_LOCKED_SHAREDCACHE has been released.
+ * Returns SQLITE_OK if the caller should retry, or SQLITE_LOCKED if waiting
+ * would deadlock. */
+class UnlockNotification {
+public:
+	static int wait(sqlite3& connectionHandle);
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_UNLOCKNOTIFICATION_H_ */
@@ -0,0 +1,262 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_VALUE_H_
+#define SQLITE4ESL_DATABASE_VALUE_H_
+
+#include <esl/database/Field.h>
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Conversion between C++ types and sqlite3_value / sqlite3_context, getDeclType()
+ * returns the column type used to declare values of the C++ type. column() decodes
+ * a result column in place, reusing the memory of "target".
+ * NULL values are converted to the default value of the C++ type, use
+ * esl::database::Field to distinguish NULL. holds() is true if get() converts the
+ * value without loss, i.e. compares like sqlite3 would compare it with a column of the
+ * C++ type. */
+template<typename T, typename Enable = void>
+struct Value;
+
+template<typename T>
+struct Value<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+	static const char* getDeclType() {
+		return "INTEGER";
+	}
+
+	static T get(sqlite3_value& value) {
+		return static_cast<T>(sqlite3_value_int64(&value));
+	}
+
+	static bool holds(sqlite3_value& value) {
+		if(sqlite3_value_numeric_type(&value) != SQLITE_INTEGER) {
+			return false;
+		}
+		sqlite3_int64 intValue = sqlite3_value_int64(&value);
+		if(std::is_signed<T>::value) {
+			return intValue >= static_cast<sqlite3_int64>(std::numeric_limits<T>::min())
+					&& intValue <= static_cast<sqlite3_int64>(std::numeric_limits<T>::max());
+		}
+		return intValue >= 0 && static_cast<std::uint64_t>(intValue) <= static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+	}
+
+	static void column(sqlite3_stmt& statement, int index, T& target) {
+		target = static_cast<T>(sqlite3_column_int64(&statement, index));
+	}
+
+	static void result(sqlite3_context& context, T value) {
+		sqlite3_result_int64(&context, static_cast<sqlite3_int64>(value));
+	}
+};
+
+template<typename T>
+struct Value<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+	static const char* getDeclType() {
+		return "REAL";
+	}
+
+	static T get(sqlite3_value& value) {
+		return static_cast<T>(sqlite3_value_double(&value));
+	}
+
+	static bool holds(sqlite3_value& value) {
+		switch(sqlite3_value_numeric_type(&value)) {
+		case SQLITE_FLOAT:
+			return true;
+		case SQLITE_INTEGER:
+			/* integers up to 2^53 are exact as double */
+			return sqlite3_value_int64(&value) >= -(static_cast<sqlite3_int64>(1) << 53)
+					&& sqlite3_value_int64(&value) <= (static_cast<sqlite3_int64>(1) << 53);
+		default:
+			return false;
+		}
+	}
+
+	static void column(sqlite3_stmt& statement, int index, T& target) {
+		target = static_cast<T>(sqlite3_column_double(&statement, index));
+	}
+
+	static void result(sqlite3_context& context, T value) {
+		sqlite3_result_double(&context, static_cast<double>(value));
+	}
+};
+
+template<>
+struct Value<bool> {
+	static const char* getDeclType() {
+		return "INTEGER";
+	}
+
+	static bool get(sqlite3_value& value) {
+		return sqlite3_value_int64(&value) != 0;
+	}
+
+	static bool holds(sqlite3_value& value) {
+		return sqlite3_value_numeric_type(&value) == SQLITE_INTEGER && (sqlite3_value_int64(&value) == 0 || sqlite3_value_int64(&value) == 1);
+	}
+
+	static void column(sqlite3_stmt& statement, int index, bool& target) {
+		target = sqlite3_column_int64(&statement, index) != 0;
+	}
+
+	static void result(sqlite3_context& context, bool value) {
+		sqlite3_result_int(&context, value ? 1 : 0);
+	}
+};
+
+template<>
+struct Value<std::string> {
+	static const char* getDeclType() {
+		return "TEXT";
+	}
+
+	static std::string get(sqlite3_value& value) {
+		const char* data = reinterpret_cast<const char*>(sqlite3_value_text(&value));
+		if(data == nullptr) {
+			return "";
+		}
+		return std::string(data, static_cast<std::size_t>(sqlite3_value_bytes(&value)));
+	}
+
+	static bool holds(sqlite3_value& value) {
+		return sqlite3_value_type(&value) == SQLITE_TEXT;
+	}
+
+	static void column(sqlite3_stmt& statement, int index, std::string& target) {
+		const char* data = reinterpret_cast<const char*>(sqlite3_column_text(&statement, index));
+		if(data == nullptr) {
+			target.clear();
+			return;
+		}
+		target.assign(data, static_cast<std::size_t>(sqlite3_column_bytes(&statement, index)));
+	}
+
+	static void result(sqlite3_context& context, const std::string& value) {
+		sqlite3_result_text(&context, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+	}
+};
+
+template<>
+struct Value<std::vector<std::uint8_t>> {
+	static const char* getDeclType() {
+		return "BLOB";
+	}
+
+	static std::vector<std::uint8_t> get(sqlite3_value& value) {
+		const std::uint8_t* data = static_cast<const std::uint8_t*>(sqlite3_value_blob(&value));
+		if(data == nullptr) {
+			return std::vector<std::uint8_t>();
+		}
+		return std::vector<std::uint8_t>(data, data + sqlite3_value_bytes(&value));
+	}
+
+	static bool holds(sqlite3_value& value) {
+		return sqlite3_value_type(&value) == SQLITE_BLOB;
+	}
+
+	static void column(sqlite3_stmt& statement, int index, std::vector<std::uint8_t>& target) {
+		const std::uint8_t* data = static_cast<const std::uint8_t*>(sqlite3_column_blob(&statement, index));
+		if(data == nullptr) {
+			target.clear();
+			return;
+		}
+		target.assign(data, data + sqlite3_column_bytes(&statement, index));
+	}
+
+	static void result(sqlite3_context& context, const std::vector<std::uint8_t>& value) {
+		sqlite3_result_blob(&context, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+	}
+};
+
+template<>
+struct Value<esl::database::Field> {
+	static const char* getDeclType() {
+		return "";
+	}
+
+	static esl::database::Field get(sqlite3_value& value) {
+		esl::database::Field field;
+
+		switch(sqlite3_value_type(&value)) {
+		case SQLITE_INTEGER:
+			field = static_cast<std::int64_t>(sqlite3_value_int64(&value));
+			break;
+		case SQLITE_FLOAT:
+			field = sqlite3_value_double(&value);
+			break;
+		case SQLITE_TEXT:
+		case SQLITE_BLOB:
+			field = Value<std::string>::get(value);
+			break;
+		case SQLITE_NULL:
+		default:
+			field = nullptr;
+			break;
+		}
+
+		return field;
+	}
+
+	/* values of different storage classes do not compare like in sqlite3 */
+	static bool holds(sqlite3_value&) {
+		return false;
+	}
+
+	static void column(sqlite3_stmt& statement, int index, esl::database::Field& target) {
+		target = get(*sqlite3_column_value(&statement, index));
+	}
+
+	static void result(sqlite3_context& context, const esl::database::Field& value) {
+		if(value.isNull()) {
+			sqlite3_result_null(&context);
+			return;
+		}
+
+		switch(value.getSimpleType()) {
+		case esl::database::Field::Type::storageBoolean:
+		case esl::database::Field::Type::storageInteger:
+			Value<std::int64_t>::result(context, value.asInteger());
+			break;
+		case esl::database::Field::Type::storageDouble:
+			Value<double>::result(context, value.asDouble());
+			break;
+		case esl::database::Field::Type::storageString:
+			Value<std::string>::result(context, value.asString());
+			break;
+		case esl::database::Field::Type::storageEmpty:
+			sqlite3_result_null(&context);
+			break;
+		}
+	}
+};
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_VALUE_H_ */
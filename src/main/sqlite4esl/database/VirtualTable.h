@@ -0,0 +1,455 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_VIRTUALTABLE_H_
+#define SQLITE4ESL_DATABASE_VIRTUALTABLE_H_
+
+#include <sqlite4esl/database/Value.h>
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <esl/system/Stacktrace.h>
+
+#include <sqlite3.h>
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+
+/* Exposes a random access container (std::vector<T>, std::deque<T>, ...) as read only,
+ * eponymous virtual table. Rows are read in place, nothing is copied into sqlite3.
+ * The container must outlive the connection factory and must not be modified while
+ * it is queried.
+ *
+ *   VirtualTable<std::vector<Item>> items("items", itemVector);
+ *   items.column("id", &Item::id, true)
+ *        .column("name", &Item::name);
+ *   connection.addVirtualTable(std::move(items));
+ *   // SELECT name FROM items WHERE id BETWEEN 10 AND 20
+ *
+ * Columns declared as "sorted" must be in ascending order within the container
+ * (by operator<).
+ * Equality and range constraints on such a column are resolved by binary search
+ * and ORDER BY on it is consumed, all other constraints are checked by sqlite3.
+ * The rowid of a row is its position within the container. */
+template<typename Container>
+class VirtualTable {
+public:
+	using Row = typename Container::value_type;
+
+	VirtualTable(std::string name, const Container& rows);
+
+	template<typename T>
+	VirtualTable& column(std::string name, T Row::*member, bool sorted = false);
+
+	template<typename Callable>
+	VirtualTable& column(std::string name, Callable callable, bool sorted = false);
+
+	const std::string& getName() const noexcept;
+
+	void install(sqlite3& connectionHandle) const;
+
+private:
+	struct Column {
+		std::string name;
+		std::string declType;
+		std::function<void(sqlite3_context&, const Row&)> result;
+		std::function<int(const Row&, sqlite3_value&)> compare;
+		/* false if the value cannot be compared with "compare", see Value<T>::holds() */
+		std::function<bool(sqlite3_value&)> holds;
+	};
+
+	struct Table {
+		sqlite3_vtab base;
+		const VirtualTable* virtualTable;
+	};
+
+	struct Cursor {
+		sqlite3_vtab_cursor base;
+		std::size_t current;
+		std::size_t end;
+	};
+
+	enum IndexFlags {
+		indexEq = 1,
+		indexGt = 2,
+		indexGe = 4,
+		indexLt = 8,
+		indexLe = 16,
+		indexColumnShift = 8
+	};
+
+	template<typename T, typename Getter>
+	VirtualTable& addColumn(std::string name, Getter getter, bool sorted);
+
+	std::size_t lowerBound(const Column& column, sqlite3_value& value, std::size_t begin, std::size_t end, bool inclusive) const;
+
+	static int xConnect(sqlite3* db, void* aux, int argc, const char* const* argv, sqlite3_vtab** vtab, char** errMsg);
+	static int xDisconnect(sqlite3_vtab* vtab);
+	static int xBestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info);
+	static int xOpen(sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor);
+	static int xClose(sqlite3_vtab_cursor* cursor);
+	static int xFilter(sqlite3_vtab_cursor* cursor, int indexNumber, const char* indexString, int argc, sqlite3_value** argv);
+	static int xNext(sqlite3_vtab_cursor* cursor);
+	static int xEof(sqlite3_vtab_cursor* cursor);
+	static int xColumn(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int columnIndex);
+	static int xRowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid);
+
+	static const VirtualTable& getVirtualTable(sqlite3_vtab_cursor* cursor) {
+		return *reinterpret_cast<Table*>(cursor->pVtab)->virtualTable;
+	}
+
+	std::string name;
+	const Container& rows;
+	std::vector<Column> columns;
+	sqlite3_module module;
+};
+
+template<typename Container>
+VirtualTable<Container>::VirtualTable(std::string aName, const Container& aRows)
+: name(std::move(aName)),
+  rows(aRows),
+  module()
+{
+	module.iVersion = 1;
+	/* xCreate is null for an eponymous-only virtual table */
+	module.xCreate = nullptr;
+	module.xConnect = xConnect;
+	module.xBestIndex = xBestIndex;
+	module.xDisconnect = xDisconnect;
+	module.xDestroy = xDisconnect;
+	module.xOpen = xOpen;
+	module.xClose = xClose;
+	module.xFilter = xFilter;
+	module.xNext = xNext;
+	module.xEof = xEof;
+	module.xColumn = xColumn;
+	module.xRowid = xRowid;
+}
+
+template<typename Container>
+template<typename T>
+VirtualTable<Container>& VirtualTable<Container>::column(std::string name, T Row::*member, bool sorted) {
+	return addColumn<T>(std::move(name), [member](const Row& row) -> const T& { return row.*member; }, sorted);
+}
+
+template<typename Container>
+template<typename Callable>
+VirtualTable<Container>& VirtualTable<Container>::column(std::string name, Callable callable, bool sorted) {
+	using T = typename std::decay<typename std::result_of<Callable(const Row&)>::type>::type;
+	return addColumn<T>(std::move(name), std::move(callable), sorted);
+}
+
+template<typename Container>
+template<typename T, typename Getter>
+VirtualTable<Container>& VirtualTable<Container>::addColumn(std::string columnName, Getter getter, bool sorted) {
+	Column column;
+	column.name = std::move(columnName);
+	column.declType = Value<T>::getDeclType();
+	column.result = [getter](sqlite3_context& context, const Row& row) {
+		Value<T>::result(context, getter(row));
+	};
+	if(sorted) {
+		column.compare = [getter](const Row& row, sqlite3_value& value) {
+			const T key = Value<T>::get(value);
+			const T& rowValue = getter(row);
+			return rowValue < key ? -1 : (key < rowValue ? 1 : 0);
+		};
+		column.holds = [](sqlite3_value& value) {
+			return Value<T>::holds(value);
+		};
+	}
+	columns.push_back(std::move(column));
+	return *this;
+}
+
+template<typename Container>
+const std::string& VirtualTable<Container>::getName() const noexcept {
+	return name;
+}
+
+template<typename Container>
+void VirtualTable<Container>::install(sqlite3& connectionHandle) const {
+	int rc = sqlite3_create_module_v2(&connectionHandle, name.c_str(), &module, const_cast<VirtualTable*>(this), nullptr);
+	if(rc != SQLITE_OK) {
+        throw esl::system::Stacktrace::add(exception::SQLiteError("Can't register virtual table \"" + name + "\"", rc, &connectionHandle));
+	}
+}
+
+template<typename Container>
+std::size_t VirtualTable<Container>::lowerBound(const Column& column, sqlite3_value& value, std::size_t begin, std::size_t end, bool inclusive) const {
+	/* first row within [begin, end) that is ">= value" (inclusive) or "> value" */
+	while(begin < end) {
+		std::size_t middle = begin + (end - begin) / 2;
+		int rc = column.compare(rows[middle], value);
+		if(rc < 0 || (rc == 0 && !inclusive)) {
+			begin = middle + 1;
+		}
+		else {
+			end = middle;
+		}
+	}
+	return begin;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xConnect(sqlite3* db, void* aux, int, const char* const*, sqlite3_vtab** vtab, char** errMsg) {
+	const VirtualTable& virtualTable = *static_cast<const VirtualTable*>(aux);
+
+	std::string sql = "CREATE TABLE x(";
+	for(std::size_t i=0; i<virtualTable.columns.size(); ++i) {
+		if(i > 0) {
+			sql += ", ";
+		}
+		sql += "\"" + virtualTable.columns[i].name + "\" " + virtualTable.columns[i].declType;
+	}
+	sql += ")";
+
+	int rc = sqlite3_declare_vtab(db, sql.c_str());
+	if(rc != SQLITE_OK) {
+		*errMsg = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+		return rc;
+	}
+
+	Table* table = static_cast<Table*>(sqlite3_malloc(sizeof(Table)));
+	if(table == nullptr) {
+		return SQLITE_NOMEM;
+	}
+	table->base = sqlite3_vtab();
+	table->virtualTable = &virtualTable;
+	*vtab = &table->base;
+
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xDisconnect(sqlite3_vtab* vtab) {
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xBestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
+	const VirtualTable& virtualTable = *reinterpret_cast<Table*>(vtab)->virtualTable;
+	const double rowCount = static_cast<double>(virtualTable.rows.size()) + 1.0;
+
+	int indexColumn = -1;
+	int eqConstraint = -1;
+	int lowerConstraint = -1;
+	int upperConstraint = -1;
+	int flags = 0;
+
+	for(int i=0; i<info->nConstraint; ++i) {
+		const sqlite3_index_info::sqlite3_index_constraint& constraint = info->aConstraint[i];
+		if(!constraint.usable || constraint.iColumn < 0 || !virtualTable.columns[constraint.iColumn].compare) {
+			continue;
+		}
+		/* the container is sorted by operator<, i.e. BINARY, other collations are
+		 * evaluated by sqlite3 */
+		const char* collation = sqlite3_vtab_collation(info, i);
+		if(collation == nullptr || sqlite3_stricmp(collation, "BINARY") != 0) {
+			continue;
+		}
+		if(indexColumn >= 0 && indexColumn != constraint.iColumn) {
+			continue;
+		}
+
+		switch(constraint.op) {
+		case SQLITE_INDEX_CONSTRAINT_EQ:
+			if(eqConstraint < 0) {
+				eqConstraint = i;
+				flags |= indexEq;
+			}
+			break;
+		case SQLITE_INDEX_CONSTRAINT_GT:
+		case SQLITE_INDEX_CONSTRAINT_GE:
+			if(lowerConstraint < 0) {
+				lowerConstraint = i;
+				flags |= constraint.op == SQLITE_INDEX_CONSTRAINT_GT ? indexGt : indexGe;
+			}
+			break;
+		case SQLITE_INDEX_CONSTRAINT_LT:
+		case SQLITE_INDEX_CONSTRAINT_LE:
+			if(upperConstraint < 0) {
+				upperConstraint = i;
+				flags |= constraint.op == SQLITE_INDEX_CONSTRAINT_LT ? indexLt : indexLe;
+			}
+			break;
+		default:
+			continue;
+		}
+		indexColumn = constraint.iColumn;
+	}
+
+	if(eqConstraint >= 0) {
+		/* an equality constraint makes range constraints on the same column redundant */
+		flags = indexEq;
+		lowerConstraint = -1;
+		upperConstraint = -1;
+	}
+
+	int argvIndex = 0;
+	for(int constraint : { eqConstraint, lowerConstraint, upperConstraint }) {
+		if(constraint >= 0) {
+			info->aConstraintUsage[constraint].argvIndex = ++argvIndex;
+		}
+	}
+
+	if(flags == 0) {
+		info->estimatedCost = rowCount;
+		info->estimatedRows = static_cast<sqlite3_int64>(rowCount);
+	}
+	else if(flags == indexEq) {
+		info->estimatedCost = std::log2(rowCount) + 1.0;
+		info->estimatedRows = 1;
+	}
+	else {
+		info->estimatedCost = std::log2(rowCount) + rowCount / ((lowerConstraint >= 0 && upperConstraint >= 0) ? 16.0 : 4.0);
+		info->estimatedRows = static_cast<sqlite3_int64>(rowCount / 4.0);
+	}
+	info->idxNum = flags == 0 ? 0 : (flags | (indexColumn << indexColumnShift));
+
+	/* Rows are delivered in container order. sqlite3 only passes ORDER BY terms whose
+	 * collation is the declared collation of the column, which is BINARY. */
+	if(info->nOrderBy == 1 && info->aOrderBy[0].iColumn >= 0 && !info->aOrderBy[0].desc && virtualTable.columns[info->aOrderBy[0].iColumn].compare) {
+		info->orderByConsumed = 1;
+	}
+
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xOpen(sqlite3_vtab*, sqlite3_vtab_cursor** cursor) {
+	Cursor* newCursor = static_cast<Cursor*>(sqlite3_malloc(sizeof(Cursor)));
+	if(newCursor == nullptr) {
+		return SQLITE_NOMEM;
+	}
+	newCursor->base = sqlite3_vtab_cursor();
+	newCursor->current = 0;
+	newCursor->end = 0;
+	*cursor = &newCursor->base;
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xClose(sqlite3_vtab_cursor* cursor) {
+	sqlite3_free(cursor);
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xFilter(sqlite3_vtab_cursor* cursor, int indexNumber, const char*, int argc, sqlite3_value** argv) {
+	const VirtualTable& virtualTable = getVirtualTable(cursor);
+	Cursor& tableCursor = *reinterpret_cast<Cursor*>(cursor);
+
+	tableCursor.current = 0;
+	tableCursor.end = virtualTable.rows.size();
+	if(indexNumber == 0) {
+		return SQLITE_OK;
+	}
+
+	for(int i=0; i<argc; ++i) {
+		if(sqlite3_value_type(argv[i]) == SQLITE_NULL) {
+			/* no row compares to NULL */
+			tableCursor.end = 0;
+			return SQLITE_OK;
+		}
+	}
+
+	try {
+		const Column& column = virtualTable.columns[indexNumber >> indexColumnShift];
+		int argvIndex = 0;
+
+		/* Constraints are not omitted, so sqlite3 checks every row again. A value that
+		 * does not convert exactly to the column type (e.g. 2.5 for an integer column)
+		 * does not narrow the range, sqlite3 filters the rows instead. */
+		if(indexNumber & indexEq) {
+			if(column.holds(*argv[argvIndex])) {
+				tableCursor.current = virtualTable.lowerBound(column, *argv[argvIndex], tableCursor.current, tableCursor.end, true);
+				tableCursor.end = virtualTable.lowerBound(column, *argv[argvIndex], tableCursor.current, tableCursor.end, false);
+			}
+			++argvIndex;
+		}
+		if(indexNumber & (indexGt | indexGe)) {
+			if(column.holds(*argv[argvIndex])) {
+				tableCursor.current = virtualTable.lowerBound(column, *argv[argvIndex], tableCursor.current, tableCursor.end, (indexNumber & indexGe) != 0);
+			}
+			++argvIndex;
+		}
+		if(indexNumber & (indexLt | indexLe)) {
+			if(column.holds(*argv[argvIndex])) {
+				tableCursor.end = virtualTable.lowerBound(column, *argv[argvIndex], tableCursor.current, tableCursor.end, (indexNumber & indexLt) != 0);
+			}
+			++argvIndex;
+		}
+	}
+	catch(const std::exception& e) {
+		sqlite3_free(cursor->pVtab->zErrMsg);
+		cursor->pVtab->zErrMsg = sqlite3_mprintf("%s", e.what());
+		return SQLITE_ERROR;
+	}
+
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xNext(sqlite3_vtab_cursor* cursor) {
+	++reinterpret_cast<Cursor*>(cursor)->current;
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xEof(sqlite3_vtab_cursor* cursor) {
+	const Cursor& tableCursor = *reinterpret_cast<Cursor*>(cursor);
+	return tableCursor.current >= tableCursor.end ? 1 : 0;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xColumn(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int columnIndex) {
+	const VirtualTable& virtualTable = getVirtualTable(cursor);
+	const Cursor& tableCursor = *reinterpret_cast<Cursor*>(cursor);
+
+	try {
+		virtualTable.columns[columnIndex].result(*context, virtualTable.rows[tableCursor.current]);
+	}
+	catch(const std::exception& e) {
+		sqlite3_result_error(context, e.what(), -1);
+	}
+	return SQLITE_OK;
+}
+
+template<typename Container>
+int VirtualTable<Container>::xRowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid) {
+	*rowid = static_cast<sqlite3_int64>(reinterpret_cast<Cursor*>(cursor)->current);
+	return SQLITE_OK;
+}
+
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_VIRTUALTABLE_H_ */
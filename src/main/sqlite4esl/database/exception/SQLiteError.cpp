@@ -0,0 +1,86 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sqlite4esl/database/exception/SQLiteError.h>
+
+#include <utility>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace exception {
+
+namespace {
+std::string toErrorMessage(int extendedCode, sqlite3* connectionHandle) {
+	if(connectionHandle && sqlite3_extended_errcode(connectionHandle) == extendedCode) {
+		return sqlite3_errmsg(connectionHandle);
+	}
+	return sqlite3_errstr(extendedCode);
+}
+}
+
+SQLiteError::SQLiteError(const std::string& message, int aExtendedCode, sqlite3* connectionHandle)
+: SQLiteError(message, aExtendedCode, toErrorMessage(aExtendedCode, connectionHandle))
+{ }
+
+SQLiteError::SQLiteError(const std::string& message, int aExtendedCode, std::string aErrorMessage)
+: std::runtime_error(message + ": " + aErrorMessage + " (" + std::to_string(aExtendedCode) + ")"),
+  extendedCode(aExtendedCode),
+  errorMessage(std::move(aErrorMessage))
+{ }
+
+int SQLiteError::getCode() const noexcept {
+	return extendedCode & 0xff;
+}
+
+int SQLiteError::getExtendedCode() const noexcept {
+	return extendedCode;
+}
+
+const std::string& SQLiteError::getErrorMessage() const noexcept {
+	return errorMessage;
+}
+
+bool SQLiteError::isBusy() const noexcept {
+	return getCode() == SQLITE_BUSY;
+}
+
+bool SQLiteError::isLocked() const noexcept {
+	return getCode() == SQLITE_LOCKED;
+}
+
+bool SQLiteError::isSchemaChanged() const noexcept {
+	return getCode() == SQLITE_SCHEMA;
+}
+
+bool SQLiteError::isConstraintViolation() const noexcept {
+	return getCode() == SQLITE_CONSTRAINT;
+}
+
+bool SQLiteError::isInterrupted() const noexcept {
+	return getCode() == SQLITE_INTERRUPT;
+}
+
+bool SQLiteError::isTransient() const noexcept {
+	return isBusy() || isLocked() || isSchemaChanged();
+}
+
+} /* namespace exception */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
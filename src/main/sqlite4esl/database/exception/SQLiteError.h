@@ -0,0 +1,65 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE4ESL_DATABASE_EXCEPTION_SQLITEERROR_H_
+#define SQLITE4ESL_DATABASE_EXCEPTION_SQLITEERROR_H_
+
+#include <sqlite3.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace exception {
+
+/* Error reported by a sqlite3 API call. Extended result codes are enabled on every
+ * handle, so getExtendedCode() distinguishes e.g. SQLITE_BUSY_SNAPSHOT from SQLITE_BUSY. */
+class SQLiteError : public std::runtime_error {
+public:
+	/* "connectionHandle" may be nullptr, otherwise sqlite3_errmsg is added to the message */
+	SQLiteError(const std::string& message, int extendedCode, sqlite3* connectionHandle = nullptr);
+
+	int getCode() const noexcept;
+	int getExtendedCode() const noexcept;
+	const std::string& getErrorMessage() const noexcept;
+
+	bool isBusy() const noexcept;
+	bool isLocked() const noexcept;
+	bool isSchemaChanged() const noexcept;
+	bool isConstraintViolation() const noexcept;
+	bool isInterrupted() const noexcept;
+
+	/* BUSY, LOCKED and SCHEMA errors may succeed if the statement is executed again.
+	 * SQLITE_BUSY_SNAPSHOT requires to run the whole transaction again. */
+	bool isTransient() const noexcept;
+
+private:
+	SQLiteError(const std::string& message, int extendedCode, std::string errorMessage);
+
+	int extendedCode;
+	std::string errorMessage;
+};
+
+} /* namespace exception */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#endif /* SQLITE4ESL_DATABASE_EXCEPTION_SQLITEERROR_H_ */
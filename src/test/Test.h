@@ -0,0 +1,58 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SQLITE4ESL_TEST_TEST_H_
+#define SQLITE4ESL_TEST_TEST_H_
+
+#include <string>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace test {
+
+/* Registers a test function that is run by main()
+ *
+ *   SQLITE4ESL_TEST(resultCacheIsInvalidatedOnCommit) {
+ *       SQLITE4ESL_CHECK(1 + 1 == 2);
+ *   }
+ */
+struct Registration {
+	Registration(const char* name, void (*function)());
+};
+
+/* Throws if "condition" is false, which fails the current test */
+void check(bool condition, const char* expression, const char* file, int line);
+void checkEqual(const std::string& actual, const std::string& expected, const char* expression, const char* file, int line);
+
+} /* namespace test */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+#define SQLITE4ESL_TEST(name) \
+	static void name(); \
+	static ::sqlite4esl::test::Registration name##Registration(#name, name); \
+	static void name()
+
+#define SQLITE4ESL_CHECK(condition) \
+	::sqlite4esl::test::check((condition), #condition, __FILE__, __LINE__)
+
+#define SQLITE4ESL_CHECK_EQUAL(actual, expected) \
+	::sqlite4esl::test::checkEqual((actual), (expected), #actual, __FILE__, __LINE__)
+
+#endif /* SQLITE4ESL_TEST_TEST_H_ */
@@ -0,0 +1,80 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace test {
+
+namespace {
+std::vector<std::pair<const char*, void (*)()>>& getTests() {
+	static std::vector<std::pair<const char*, void (*)()>> tests;
+	return tests;
+}
+}
+
+Registration::Registration(const char* name, void (*function)()) {
+	getTests().emplace_back(name, function);
+}
+
+void check(bool condition, const char* expression, const char* file, int line) {
+	if(!condition) {
+		throw std::runtime_error(std::string(file) + ":" + std::to_string(line) + ": check failed: " + expression);
+	}
+}
+
+void checkEqual(const std::string& actual, const std::string& expected, const char* expression, const char* file, int line) {
+	if(actual != expected) {
+		throw std::runtime_error(std::string(file) + ":" + std::to_string(line) + ": " + expression + " is \"" + actual + "\" instead of \"" + expected + "\"");
+	}
+}
+
+} /* namespace test */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
+
+int main() {
+	std::size_t failed = 0;
+
+	for(const auto& test : sqlite4esl::test::getTests()) {
+		try {
+			test.second();
+			std::cout << "[ OK     ] " << test.first << "\n";
+		}
+		catch(const std::exception& e) {
+			++failed;
+			std::cout << "[ FAILED ] " << test.first << ": " << e.what() << "\n";
+		}
+		catch(...) {
+			++failed;
+			std::cout << "[ FAILED ] " << test.first << ": unknown exception\n";
+		}
+	}
+
+	std::cout << sqlite4esl::test::getTests().size() - failed << " of " << sqlite4esl::test::getTests().size() << " tests passed\n";
+	return failed == 0 ? 0 : 1;
+}
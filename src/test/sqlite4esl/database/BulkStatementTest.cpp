@@ -0,0 +1,135 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/PreparedBulkStatementBinding.h>
+
+#include <esl/database/Field.h>
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace {
+
+esl::database::SQLiteConnectionFactory::Settings makeSettings() {
+	return esl::database::SQLiteConnectionFactory::Settings(std::vector<std::pair<std::string, std::string>>{
+		{"URI", ":memory:"},
+		{"bulkBatchRows", "4"}
+	});
+}
+
+std::vector<esl::database::Field> makeRow(std::int64_t value) {
+	std::vector<esl::database::Field> row(1);
+	row[0] = value;
+	return row;
+}
+
+std::int64_t count(const Connection& connection) {
+	StatementHandle statementHandle = connection.prepareSQLite("SELECT count(*) FROM t");
+	statementHandle.step();
+	return statementHandle.columnInteger(0);
+}
+
+bool throws(const std::function<void()>& function) {
+	try {
+		function();
+	}
+	catch(const std::exception&) {
+		return true;
+	}
+	return false;
+}
+
+SQLITE4ESL_TEST(bulkStatementRowsAreVisibleWithinTheTransaction) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+
+	PreparedBulkStatementBinding bulkStatement(connection, "INSERT INTO t (x) VALUES (?)");
+	connection.prepareSQLite("BEGIN").step();
+	bulkStatement.execute(makeRow(1));
+	bulkStatement.execute(makeRow(2));
+	SQLITE4ESL_CHECK(count(connection) == 2);
+
+	bulkStatement.execute(makeRow(3));
+	connection.rollback();
+	SQLITE4ESL_CHECK(count(connection) == 0);
+}
+
+SQLITE4ESL_TEST(bulkStatementWritesImmediatelyWithoutTransaction) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x PRIMARY KEY)").step();
+
+	PreparedBulkStatementBinding bulkStatement(connection, "INSERT INTO t (x) VALUES (?)");
+	bulkStatement.execute(makeRow(1));
+	SQLITE4ESL_CHECK(sqlite3_total_changes(&const_cast<sqlite3&>(connection.getConnectionHandle())) == 1);
+	SQLITE4ESL_CHECK(throws([&bulkStatement] { bulkStatement.execute(makeRow(1)); }));
+	SQLITE4ESL_CHECK(count(connection) == 1);
+}
+
+SQLITE4ESL_TEST(bulkStatementReportsErrorsOfBufferedRows) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x PRIMARY KEY)").step();
+
+	{
+		/* the execute() that fills the batch fails */
+		PreparedBulkStatementBinding bulkStatement(connection, "INSERT INTO t (x) VALUES (?)");
+		connection.prepareSQLite("BEGIN").step();
+		bulkStatement.execute(makeRow(1));
+		bulkStatement.execute(makeRow(2));
+		bulkStatement.execute(makeRow(3));
+		SQLITE4ESL_CHECK(throws([&bulkStatement] { bulkStatement.execute(makeRow(1)); }));
+		connection.rollback();
+	}
+
+	{
+		/* rows that cannot be written by the destructor make the commit fail */
+		connection.prepareSQLite("BEGIN").step();
+		{
+			PreparedBulkStatementBinding bulkStatement(connection, "INSERT INTO t (x) VALUES (?)");
+			bulkStatement.execute(makeRow(1));
+			bulkStatement.execute(makeRow(1));
+		}
+		SQLITE4ESL_CHECK(throws([&connection] { connection.commit(); }));
+		connection.rollback();
+		SQLITE4ESL_CHECK(count(connection) == 0);
+	}
+}
+
+} /* anonymous namespace */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,156 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <sqlite4esl/database/ChangeCapture.h>
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace {
+
+esl::database::SQLiteConnectionFactory::Settings makeSettings() {
+	return esl::database::SQLiteConnectionFactory::Settings(std::vector<std::pair<std::string, std::string>>{
+		{"URI", ":memory:"},
+		{"changeCapture", "true"},
+		{"changeCaptureValues", ChangeCapture::isValueCaptureAvailable() ? "true" : "false"}
+	});
+}
+
+SQLITE4ESL_TEST(changeCapturePublishesOneBatchPerCommit) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::vector<std::vector<Change>> batches;
+	connectionFactory.subscribeChanges([&batches](const std::vector<Change>& changes) {
+		batches.push_back(changes);
+	});
+
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1), (2)").step();
+	SQLITE4ESL_CHECK(batches.size() == 1);
+	SQLITE4ESL_CHECK(batches[0].size() == 2);
+
+	connection.prepareSQLite("BEGIN").step();
+	connection.prepareSQLite("UPDATE t SET x = 5 WHERE rowid = 1").step();
+	connection.prepareSQLite("DELETE FROM t WHERE rowid = 2").step();
+	/* nothing is published before the commit */
+	SQLITE4ESL_CHECK(batches.size() == 1);
+
+	connection.commit();
+	SQLITE4ESL_CHECK(batches.size() == 2);
+	const std::vector<Change>& changes = batches[1];
+	SQLITE4ESL_CHECK(changes.size() == 2);
+	SQLITE4ESL_CHECK_EQUAL(changes[0].table, "t");
+	SQLITE4ESL_CHECK(changes[0].operation == Change::Operation::update);
+	SQLITE4ESL_CHECK(changes[0].rowid == 1);
+	SQLITE4ESL_CHECK(changes[1].operation == Change::Operation::remove);
+	SQLITE4ESL_CHECK(changes[1].rowid == 2);
+
+	if(ChangeCapture::isValueCaptureAvailable()) {
+		SQLITE4ESL_CHECK(changes[0].oldValues.size() == 1 && changes[0].oldValues[0].asInteger() == 1);
+		SQLITE4ESL_CHECK(changes[0].newValues.size() == 1 && changes[0].newValues[0].asInteger() == 5);
+		SQLITE4ESL_CHECK(changes[1].oldValues.size() == 1 && changes[1].newValues.empty());
+	}
+}
+
+SQLITE4ESL_TEST(changeCaptureDropsRolledBackChanges) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::vector<std::vector<Change>> batches;
+	connectionFactory.subscribeChanges([&batches](const std::vector<Change>& changes) {
+		batches.push_back(changes);
+	});
+
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+
+	connection.prepareSQLite("BEGIN").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1)").step();
+	connection.rollback();
+	SQLITE4ESL_CHECK(batches.empty());
+
+	/* the next transaction does not contain the changes that have been rolled back */
+	connection.prepareSQLite("BEGIN").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(2)").step();
+	connection.commit();
+	SQLITE4ESL_CHECK(batches.size() == 1);
+	SQLITE4ESL_CHECK(batches[0].size() == 1);
+	SQLITE4ESL_CHECK(batches[0][0].operation == Change::Operation::insert);
+}
+
+SQLITE4ESL_TEST(changeCaptureReportsRowsOfDeleteWithoutWhere) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::vector<std::vector<Change>> batches;
+	connectionFactory.subscribeChanges([&batches](const std::vector<Change>& changes) {
+		batches.push_back(changes);
+	});
+
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1), (2), (3)").step();
+
+	/* would be truncated without calling the update hook */
+	connection.prepareSQLite("DELETE FROM t").step();
+	SQLITE4ESL_CHECK(batches.size() == 2);
+	SQLITE4ESL_CHECK(batches[1].size() == 3);
+	SQLITE4ESL_CHECK(batches[1][0].operation == Change::Operation::remove);
+
+	/* tables and views can still be dropped */
+	connection.prepareSQLite("CREATE VIEW v AS SELECT x FROM t").step();
+	connection.prepareSQLite("DROP VIEW v").step();
+	connection.prepareSQLite("DROP TABLE t").step();
+	StatementHandle statementHandle = connection.prepareSQLite("SELECT count(*) FROM sqlite_master");
+	statementHandle.step();
+	SQLITE4ESL_CHECK(statementHandle.columnInteger(0) == 0);
+}
+
+SQLITE4ESL_TEST(changeCaptureStopsPublishingAfterUnsubscribe) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::size_t batches = 0;
+	std::size_t id = connectionFactory.subscribeChanges([&batches](const std::vector<Change>&) {
+		++batches;
+	});
+
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1)").step();
+	SQLITE4ESL_CHECK(batches == 1);
+
+	connectionFactory.unsubscribeChanges(id);
+	connection.prepareSQLite("INSERT INTO t VALUES(2)").step();
+	SQLITE4ESL_CHECK(batches == 1);
+}
+
+} /* anonymous namespace */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,82 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/StatementHandle.h>
+
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace {
+
+const std::string countingSQL = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000000) SELECT x FROM c";
+
+SQLITE4ESL_TEST(connectionInterruptDoesNotAffectOtherConnectionsOfTheHandle) {
+	ConnectionFactory connectionFactory(esl::database::SQLiteConnectionFactory::Settings(std::vector<std::pair<std::string, std::string>>{
+		{"URI", ":memory:"}
+	}));
+	std::unique_ptr<esl::database::Connection> interruptedConnectionPtr = connectionFactory.createConnection();
+	std::unique_ptr<esl::database::Connection> otherConnectionPtr = connectionFactory.createConnection();
+	const Connection& interruptedConnection = static_cast<Connection&>(*interruptedConnectionPtr);
+	const Connection& otherConnection = static_cast<Connection&>(*otherConnectionPtr);
+	SQLITE4ESL_CHECK(&interruptedConnection.getConnectionHandle() == &otherConnection.getConnectionHandle());
+
+	StatementHandle interruptedStatement = interruptedConnection.prepareSQLite(countingSQL);
+	SQLITE4ESL_CHECK(interruptedStatement.step());
+	interruptedConnection.interrupt();
+
+	StatementHandle otherStatement = otherConnection.prepareSQLite("SELECT count(*) FROM (" + countingSQL + ")");
+	SQLITE4ESL_CHECK(otherStatement.step());
+	SQLITE4ESL_CHECK(otherStatement.columnInteger(0) == 1000000);
+
+	bool interrupted = false;
+	try {
+		while(interruptedStatement.step()) {
+		}
+	}
+	catch(const std::exception&) {
+		interrupted = true;
+	}
+	SQLITE4ESL_CHECK(interrupted);
+
+	/* the next execution is not interrupted anymore, reset() reports the interruption again */
+	try {
+		interruptedStatement.reset();
+	}
+	catch(const std::exception&) {
+	}
+	SQLITE4ESL_CHECK(interruptedStatement.step());
+	SQLITE4ESL_CHECK(interruptedStatement.columnInteger(0) == 1);
+}
+
+} /* anonymous namespace */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,147 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/ResultCache.h>
+
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace {
+
+esl::database::SQLiteConnectionFactory::Settings makeSettings() {
+	return esl::database::SQLiteConnectionFactory::Settings(std::vector<std::pair<std::string, std::string>>{
+		{"URI", ":memory:"},
+		{"resultCacheSize", "1000000"}
+	});
+}
+
+bool isCacheable(const Connection& connection, const std::string& sql) {
+	ResultCache& resultCache = *connection.getConnectionFactory().getResultCache();
+	return resultCache.getDependencies(const_cast<sqlite3&>(connection.getConnectionHandle()), sql)->cacheable;
+}
+
+SQLITE4ESL_TEST(resultCacheServesRepeatedQueries) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1)").step();
+
+	connection.prepare("SELECT x FROM t").execute();
+	connection.prepare("SELECT x FROM t").execute();
+
+	ResultCache::Statistics statistics = connectionFactory.getResultCache()->getStatistics();
+	SQLITE4ESL_CHECK(statistics.misses == 1);
+	SQLITE4ESL_CHECK(statistics.hits == 1);
+	SQLITE4ESL_CHECK(statistics.entries == 1);
+}
+
+SQLITE4ESL_TEST(resultCacheIsInvalidatedOnCommit) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("CREATE TABLE u(x)").step();
+
+	connection.prepare("SELECT x FROM t").execute();
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 1);
+
+	/* writes to other tables keep the entry */
+	connection.prepareSQLite("INSERT INTO u VALUES(1)").step();
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 1);
+
+	/* uncommitted writes keep the entry until the commit */
+	connection.prepareSQLite("BEGIN").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1)").step();
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 1);
+	connection.commit();
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 0);
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().invalidations == 1);
+
+	/* autocommit statements invalidate as well */
+	connection.prepare("SELECT x FROM t").execute();
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 1);
+	connection.prepareSQLite("DELETE FROM t").step();
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 0);
+}
+
+SQLITE4ESL_TEST(resultCacheIsInvalidatedByJoinedTables) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("CREATE TABLE u(x)").step();
+	connection.prepareSQLite("CREATE VIEW v AS SELECT x FROM u").step();
+
+	/* u is only read by the join constraint */
+	for(const char* sql : { "SELECT count(*) FROM t JOIN u USING (x)", "SELECT x FROM t NATURAL JOIN u", "SELECT count(*) FROM t, v WHERE t.x = v.x" }) {
+		SQLITE4ESL_CHECK(isCacheable(connection, sql));
+		connection.prepare(sql).execute();
+		SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 1);
+		connection.prepareSQLite("INSERT INTO u VALUES(1)").step();
+		SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 0);
+	}
+}
+
+SQLITE4ESL_TEST(resultCacheKeepsEntriesOnRollback) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+
+	connection.prepare("SELECT x FROM t").execute();
+	connection.prepareSQLite("BEGIN").step();
+	connection.prepareSQLite("INSERT INTO t VALUES(1)").step();
+	connection.rollback();
+
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().entries == 1);
+	SQLITE4ESL_CHECK(connectionFactory.getResultCache()->getStatistics().invalidations == 0);
+}
+
+SQLITE4ESL_TEST(resultCacheSkipsTablesWithoutUpdateHook) {
+	ConnectionFactory connectionFactory(makeSettings());
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+	connection.prepareSQLite("CREATE TABLE t(x)").step();
+	connection.prepareSQLite("CREATE TABLE w(x PRIMARY KEY, y) WITHOUT ROWID").step();
+	connection.prepareSQLite("CREATE TEMP TABLE m(x)").step();
+
+	SQLITE4ESL_CHECK(isCacheable(connection, "SELECT x FROM t"));
+	/* the update hook does not report changes of WITHOUT ROWID tables */
+	SQLITE4ESL_CHECK(!isCacheable(connection, "SELECT y FROM w"));
+	SQLITE4ESL_CHECK(!isCacheable(connection, "SELECT x FROM t JOIN w USING (x)"));
+	SQLITE4ESL_CHECK(!isCacheable(connection, "SELECT x FROM m"));
+	SQLITE4ESL_CHECK(!isCacheable(connection, "SELECT random() FROM t"));
+}
+
+} /* anonymous namespace */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,68 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/StatementHandle.h>
+
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <sqlite3.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace {
+
+SQLITE4ESL_TEST(statementHandleMoveAssignmentReleasesHotStatement) {
+	ConnectionFactory connectionFactory(esl::database::SQLiteConnectionFactory::Settings(std::vector<std::pair<std::string, std::string>>{
+		{"URI", ":memory:"},
+		{"hotStatement", "SELECT 1"}
+	}));
+	std::unique_ptr<esl::database::Connection> connectionPtr = connectionFactory.createConnection();
+	const Connection& connection = static_cast<Connection&>(*connectionPtr);
+
+	sqlite3_stmt* hotStatement;
+	{
+		StatementHandle statementHandle = connection.prepareSQLite("SELECT 1");
+		hotStatement = &statementHandle.getHandle();
+	}
+
+	StatementHandle statementHandle = connection.prepareSQLite("SELECT 1");
+	SQLITE4ESL_CHECK(&statementHandle.getHandle() == hotStatement);
+	statementHandle = connection.prepareSQLite("SELECT 2");
+	SQLITE4ESL_CHECK(&statementHandle.getHandle() != hotStatement);
+
+	statementHandle = connection.prepareSQLite("SELECT 1");
+	SQLITE4ESL_CHECK(&statementHandle.getHandle() == hotStatement);
+	SQLITE4ESL_CHECK(statementHandle.step());
+	SQLITE4ESL_CHECK(statementHandle.columnInteger(0) == 1);
+}
+
+} /* anonymous namespace */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */
@@ -0,0 +1,131 @@
+/*
+ * This file is part of sqlite4esl.
+ * Copyright (C) 2020-2023 Sven Lukas
+ *
+ * Sqlite4esl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sqlite4esl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser Public License
+ * along with mhd4esl.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <Test.h>
+
+#include <sqlite4esl/database/Connection.h>
+#include <sqlite4esl/database/ConnectionFactory.h>
+#include <sqlite4esl/database/VirtualTable.h>
+
+#include <esl/database/SQLiteConnectionFactory.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite4esl {
+inline namespace v1_6 {
+namespace database {
+namespace {
+
+struct Item {
+	int id;
+	std::string name;
+	double price;
+};
+
+const std::vector<Item> items {
+	{1, "a", 0.5},
+	{2, "b", 1.5},
+	{3, "c", 2.5},
+	{4, "d", 3.5}
+};
+
+class VirtualTableFixture {
+public:
+	VirtualTableFixture()
+	: connectionFactory(esl::database::SQLiteConnectionFactory::Settings(std::vector<std::pair<std::string, std::string>>{{"URI", ":memory:"}})),
+	  connectionPtr(connectionFactory.createConnection()),
+	  connection(static_cast<Connection&>(*connectionPtr))
+	{
+		VirtualTable<std::vector<Item>> virtualTable("items", items);
+		virtualTable.column("id", &Item::id, true)
+				.column("name", &Item::name, true)
+				.column("price", &Item::price);
+		connection.addVirtualTable(std::move(virtualTable));
+	}
+
+	/* ids of the rows matching "condition" */
+	std::string select(const std::string& condition) const {
+		StatementHandle statementHandle = connection.prepareSQLite("SELECT group_concat(id) FROM (SELECT id FROM items WHERE " + condition + ")");
+		statementHandle.step();
+		return statementHandle.columnValueIsNull(0) ? "" : statementHandle.columnText(0);
+	}
+
+private:
+	ConnectionFactory connectionFactory;
+	std::unique_ptr<esl::database::Connection> connectionPtr;
+
+public:
+	const Connection& connection;
+};
+
+SQLITE4ESL_TEST(virtualTableResolvesConstraintsOnSortedColumns) {
+	VirtualTableFixture fixture;
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id = 2"), "2");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id > 1 AND id < 4"), "2,3");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id BETWEEN 2 AND 3"), "2,3");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id >= 3"), "3,4");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id <= 1"), "1");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id = 5"), "");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id = NULL"), "");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name < 'c'"), "1,2");
+	/* unsorted columns are filtered by sqlite3 */
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("price > 2"), "3,4");
+}
+
+SQLITE4ESL_TEST(virtualTableIgnoresValuesOfOtherTypes) {
+	VirtualTableFixture fixture;
+	/* a value that does not convert exactly to the column type does not narrow the scan */
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id < 2.5"), "1,2");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id > 2.5"), "3,4");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id = 2.0"), "2");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id < 'abc'"), "1,2,3,4");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id = '3'"), "3");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id > 5000000000"), "");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id < 5000000000"), "1,2,3,4");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("id >= -5000000000"), "1,2,3,4");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name = 2"), "");
+}
+
+SQLITE4ESL_TEST(virtualTableLeavesOtherCollationsToSqlite) {
+	VirtualTableFixture fixture;
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name = 'B' COLLATE NOCASE"), "2");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name < 'C' COLLATE NOCASE"), "1,2");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name > 'B' COLLATE NOCASE"), "3,4");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name > 'B' COLLATE NOCASE AND name < 'D' COLLATE NOCASE"), "3");
+	SQLITE4ESL_CHECK_EQUAL(fixture.select("name = 'B'"), "");
+}
+
+SQLITE4ESL_TEST(virtualTableConsumesOrderByOnSortedColumns) {
+	VirtualTableFixture fixture;
+	StatementHandle statementHandle = fixture.connection.prepareSQLite("SELECT group_concat(id) FROM (SELECT id FROM items WHERE id >= 2 ORDER BY id)");
+	statementHandle.step();
+	SQLITE4ESL_CHECK_EQUAL(statementHandle.columnText(0), "2,3,4");
+
+	statementHandle = fixture.connection.prepareSQLite("SELECT group_concat(id) FROM (SELECT id FROM items ORDER BY id DESC)");
+	statementHandle.step();
+	SQLITE4ESL_CHECK_EQUAL(statementHandle.columnText(0), "4,3,2,1");
+}
+
+} /* anonymous namespace */
+} /* namespace database */
+} /* inline namespace v1_6 */
+} /* namespace sqlite4esl */